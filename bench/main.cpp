@@ -0,0 +1,661 @@
+
+// Benchmark harness: times the parse, part one and part two stages of every
+// registered day over repeated runs, and optionally saves the timings as a
+// baseline or compares them against one. See README.md in this directory
+// for how to build it.
+
+// This file has its own main() even when the days' are compiled out; see
+// AOC_TRACK_ALLOCS in common.hpp
+#undef AOC_NO_MAIN
+
+#include "../common.hpp"
+
+#include <cmath>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using duration = std::chrono::duration<double, std::milli>;
+
+struct options {
+    int runs = 10;
+    int warmup = 1;
+    int only_day = 0;
+    std::string input_dir;
+    std::string save_path;
+    std::string label;
+    std::string compare_path;
+    std::string parse_cache_dir;
+    double threshold = 0.05;
+    double alpha = 0.01;
+    bool verify = false;
+};
+
+// The timings of one stage of one day, and (when built with
+// AOC_TRACK_ALLOCS) its memory use on the last run
+struct stage_result {
+    std::string name;
+    std::string stage;
+    size_t input_bytes = 0;
+    std::vector<duration> samples;
+    std::optional<uint64_t> peak_bytes;
+    std::optional<uint64_t> allocations;
+};
+
+struct stage_stats {
+    duration min{};
+    duration median{};
+    duration p95{};
+};
+
+stage_stats calculate_stats(std::vector<duration> samples)
+{
+    assert(!samples.empty());
+    nano::sort(samples);
+    const auto n = samples.size();
+    const auto p95_idx = nano::min(n - 1, (n * 95 + 99) / 100 - 1);
+    return {samples.front(), samples[n / 2], samples[p95_idx]};
+}
+
+template <typename Func>
+duration time_call(Func&& func)
+{
+    const auto start = clock_type::now();
+    std::forward<Func>(func)();
+    return clock_type::now() - start;
+}
+
+std::string format_size(double bytes)
+{
+    constexpr std::array<const char*, 4> units{"B", "KB", "MB", "GB"};
+    size_t u = 0;
+    while (bytes >= 1024.0 && u < units.size() - 1) {
+        bytes /= 1024.0;
+        ++u;
+    }
+    return fmt::format("{:.1f} {}", bytes, units[u]);
+}
+
+std::string format_throughput(size_t bytes, duration d)
+{
+    if (d.count() <= 0.0) {
+        return "-";
+    }
+    return format_size(bytes / (d.count() / 1000.0)) + "/s";
+}
+
+// Inputs are looked up in the input directory by the name of the directory
+// containing the day's sources, so dec2/pt1 and dec2/pt2 both use dec2.txt
+std::string input_path(const options& opts, const aoc::day_entry& entry)
+{
+    const auto dir = std::string_view(entry.name).substr(0, entry.name.find('/'));
+    return fmt::format("{}/{}.txt", opts.input_dir, dir);
+}
+
+bool file_exists(const std::string& path)
+{
+    struct ::stat st{};
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+void print_row(const aoc::day_entry& entry, const char* stage, size_t bytes,
+               const stage_stats& s)
+{
+    fmt::print("{:<10} {:<9} {:>10} {:>11.3f} {:>11.3f} {:>11.3f} {:>14}\n",
+               entry.name, stage, format_size(bytes), s.min.count(),
+               s.median.count(), s.p95.count(), format_throughput(bytes, s.median));
+}
+
+void bench_day(const options& opts, const aoc::day_entry& entry, std::vector<stage_result>& results)
+{
+    const auto path = input_path(opts, entry);
+    if (!file_exists(path)) {
+        fmt::print(stderr, "Skipping {}: no input file {}\n", entry.name, path);
+        return;
+    }
+
+    const aoc::mapped_file file(path.c_str());
+    const auto input = file.view();
+
+    // With a parse cache, the first stage loads the parsed input from the
+    // cache instead of parsing the text, once it has made sure it's there.
+    // Small inputs are quicker to parse, so they are left alone.
+    std::optional<aoc::parse_cache> cache;
+    std::optional<aoc::parse_cache::key> key;
+    if (!opts.parse_cache_dir.empty() && entry.load_input && aoc::parse_cache::worth_caching(input)) {
+        cache.emplace(opts.parse_cache_dir);
+        key.emplace(entry, input);
+        if (!cache->find(entry, *key) && !cache->store(entry, *key, entry.parse(input))) {
+            fmt::print(stderr, "{}: could not write to the parse cache\n", entry.name);
+            cache.reset();
+        }
+    }
+    const char* first_stage = cache ? "load" : "parse";
+
+    const auto make_result = [&](const char* stage) {
+        stage_result r;
+        r.name = entry.name;
+        r.stage = stage;
+        r.input_bytes = input.size();
+        return r;
+    };
+    auto parse = make_result(first_stage);
+    auto one = make_result("part_one");
+    auto two = make_result("part_two");
+
+    // Times func(), and on the last run also records its memory use
+    const auto measure = [&](stage_result& r, bool last_run, auto&& func) {
+        using aoc::instr::alloc_stats;
+        const auto before = alloc_stats::begin_phase();
+        const auto t = time_call(func);
+        const auto [allocs, bytes, peak] = alloc_stats::end_phase(before);
+        if (alloc_stats::enabled && last_run) {
+            r.allocations = allocs;
+            r.peak_bytes = peak;
+        }
+        return t;
+    };
+
+    for (int run = 0; run < opts.warmup + opts.runs; run++) {
+        const bool last = run == opts.warmup + opts.runs - 1;
+
+        std::any parsed;
+        const auto t_parse = measure(parse, last, [&] {
+            auto found = cache ? cache->find(entry, *key) : std::nullopt;
+            parsed = found ? std::move(*found) : entry.parse(input);
+        });
+
+        duration t_one{}, t_two{};
+        if (entry.part_one) {
+            t_one = measure(one, last, [&] { entry.part_one(parsed); });
+        }
+        if (entry.part_two) {
+            t_two = measure(two, last, [&] { entry.part_two(parsed); });
+        }
+
+        if (run >= opts.warmup) {
+            parse.samples.push_back(t_parse);
+            one.samples.push_back(t_one);
+            two.samples.push_back(t_two);
+        }
+    }
+
+    print_row(entry, first_stage, input.size(), calculate_stats(parse.samples));
+    results.push_back(std::move(parse));
+    if (entry.part_one) {
+        print_row(entry, "part one", input.size(), calculate_stats(one.samples));
+        results.push_back(std::move(one));
+    }
+    if (entry.part_two) {
+        print_row(entry, "part two", input.size(), calculate_stats(two.samples));
+        results.push_back(std::move(two));
+    }
+}
+
+// Baseline files are text, starting with a line giving the format version.
+// Then comes an optional "label" line (a git revision, say), and a line for
+// each stage:
+//
+//     <day> <stage> <input bytes> <peak bytes> <allocations> <ms> <ms>...
+//
+// with "-" for the memory figures if they weren't measured. Every sample
+// is kept, so that later runs can be compared against the distribution.
+constexpr std::string_view baseline_header = "aoc-bench-baseline 1";
+
+bool save_baseline(const std::string& path, const std::string& label,
+                   const std::vector<stage_result>& results)
+{
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+
+    const auto opt = [](const std::optional<uint64_t>& v) {
+        return v ? std::to_string(*v) : std::string("-");
+    };
+
+    fmt::print(f, "{}\n", baseline_header);
+    if (!label.empty()) {
+        fmt::print(f, "label {}\n", label);
+    }
+    for (const auto& r : results) {
+        fmt::print(f, "{} {} {} {} {}", r.name, r.stage, r.input_bytes,
+                   opt(r.peak_bytes), opt(r.allocations));
+        for (const auto& d : r.samples) {
+            fmt::print(f, " {:.6f}", d.count());
+        }
+        fmt::print(f, "\n");
+    }
+
+    return std::fclose(f) == 0;
+}
+
+struct baseline {
+    std::string label;
+    std::vector<stage_result> results;
+};
+
+baseline load_baseline(const std::string& path)
+{
+    const aoc::mapped_file file(path.c_str());
+    auto lines = aoc::lines(file.view());
+    auto iter = lines.begin();
+
+    if (iter == lines.end() || *iter != baseline_header) {
+        throw std::runtime_error(fmt::format("'{}' is not a version 1 baseline file", path));
+    }
+
+    baseline b;
+    for (++iter; iter != lines.end(); ++iter) {
+        const std::string_view line = *iter;
+        if (line.substr(0, 6) == "label ") {
+            b.label = line.substr(6);
+            continue;
+        }
+
+        std::vector<std::string_view> fields;
+        for (const auto word : aoc::words(line)) {
+            fields.push_back(word);
+        }
+        if (fields.size() < 5) {
+            throw std::runtime_error(fmt::format("Bad line in '{}': {}", path, line));
+        }
+
+        const auto to_opt = [](std::string_view str) -> std::optional<uint64_t> {
+            uint64_t v = 0;
+            if (aoc::pattern{"{}"}.scan(str, v)) {
+                return v;
+            }
+            return std::nullopt;
+        };
+
+        stage_result r;
+        r.name = fields[0];
+        r.stage = fields[1];
+        r.input_bytes = to_opt(fields[2]).value_or(0);
+        r.peak_bytes = to_opt(fields[3]);
+        r.allocations = to_opt(fields[4]);
+        for (size_t i = 5; i < fields.size(); i++) {
+            double ms = 0;
+            std::from_chars(fields[i].data(), fields[i].data() + fields[i].size(), ms);
+            r.samples.emplace_back(ms);
+        }
+        b.results.push_back(std::move(r));
+    }
+
+    return b;
+}
+
+// The two-sided p-value of the Mann-Whitney U test of whether samples a and
+// b come from the same distribution. It makes no assumption about the shape
+// of the distributions, which suits timings with their long right-hand tails.
+//
+// For small samples the p-value is exact: we count how many of the ways of
+// splitting the combined ranks into groups of n1 and n2 give a rank sum at
+// least as far from the mean as the one observed. Tied values get their
+// average rank, and ranks are doubled so that these stay whole numbers.
+// Beyond that we use the normal approximation with a correction for ties,
+// which can't get below p = 0.012 or so at 5+5 samples and so would never
+// flag anything at the default level.
+double mann_whitney_p(const std::vector<duration>& a, const std::vector<duration>& b)
+{
+    const size_t n1 = a.size();
+    const size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+
+    // Rank the combined samples, giving tied values their average rank
+    std::vector<std::pair<double, bool>> all; // (value, is from a)
+    for (const auto& d : a) all.emplace_back(d.count(), true);
+    for (const auto& d : b) all.emplace_back(d.count(), false);
+    nano::sort(all, nano::less<>{}, &std::pair<double, bool>::first);
+
+    const size_t n = n1 + n2;
+    std::vector<size_t> ranks2; // twice the rank of each value, in order
+    size_t rank_sum2_a = 0;
+    double tie_term = 0;
+    for (size_t i = 0; i < all.size(); ) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            ++j;
+        }
+        const size_t avg_rank2 = i + 1 + j;
+        for (size_t k = i; k < j; k++) {
+            ranks2.push_back(avg_rank2);
+            if (all[k].second) {
+                rank_sum2_a += avg_rank2;
+            }
+        }
+        const double t = j - i;
+        tie_term += t * t * t - t;
+        i = j;
+    }
+
+    const auto dist = [](size_t x, size_t y) { return x > y ? x - y : y - x; };
+    const size_t mean2 = n1 * (n + 1);
+    const size_t observed = dist(rank_sum2_a, mean2);
+
+    constexpr size_t max_exact = 40;
+    if (n <= max_exact) {
+        // ways[k][s]: the number of ways of picking k of the ranks seen so
+        // far with a (doubled) sum of s
+        const size_t max_sum = n * (n + 1);
+        std::vector<std::vector<double>> ways(n1 + 1, std::vector<double>(max_sum + 1));
+        ways[0][0] = 1;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t k = std::min(i + 1, n1); k > 0; k--) {
+                for (size_t s = ranks2[i]; s <= max_sum; s++) {
+                    ways[k][s] += ways[k - 1][s - ranks2[i]];
+                }
+            }
+        }
+
+        double total = 0;
+        double extreme = 0;
+        for (size_t s = 0; s <= max_sum; s++) {
+            total += ways[n1][s];
+            if (dist(s, mean2) >= observed) {
+                extreme += ways[n1][s];
+            }
+        }
+        return std::min(1.0, extreme / total);
+    }
+
+    const double u = (rank_sum2_a / 2.0) - n1 * (n1 + 1) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (double(n) * (n - 1)));
+    if (var <= 0) {
+        return 1.0;
+    }
+
+    // With a continuity correction
+    const double z = std::max(0.0, std::abs(u - mean) - 0.5) / std::sqrt(var);
+    return std::erfc(z / std::sqrt(2.0));
+}
+
+// The smallest p-value mann_whitney_p() can give for samples of these
+// sizes, which is when they are all different and don't overlap at all
+double min_reachable_p(size_t n1, size_t n2)
+{
+    std::vector<duration> a, b;
+    for (size_t i = 0; i < n1 + n2; i++) {
+        (i < n1 ? a : b).emplace_back(i);
+    }
+    return mann_whitney_p(a, b);
+}
+
+// Prints how each stage in both results and the baseline has changed.
+// A stage is flagged as slower if its median time grew by more than the
+// threshold and the difference is significant at the given level, or if
+// its peak memory grew by more than the threshold. Returns the number of
+// stages flagged.
+int compare_to_baseline(const options& opts, const baseline& base,
+                        const std::vector<stage_result>& results)
+{
+    fmt::print("\nCompared with baseline {}{}(threshold {:.0f}%, p < {})\n\n",
+               opts.compare_path, base.label.empty() ? " " : fmt::format(" ({}) ", base.label),
+               opts.threshold * 100, opts.alpha);
+    fmt::print("{:<10} {:<9} {:>11} {:>11} {:>8} {:>9} {:>12}  {}\n",
+               "day", "stage", "base", "new", "change", "p", "peak mem", "");
+
+    int regressions = 0;
+    int unflaggable = 0;
+    double worst_min_p = 0;
+    for (const auto& r : results) {
+        const auto iter = nano::find_if(base.results, [&](const auto& b) {
+            return b.name == r.name && b.stage == r.stage;
+        });
+        if (iter == base.results.end() || iter->samples.empty() || r.samples.empty()) {
+            fmt::print("{:<10} {:<9} {:>11}\n", r.name, r.stage, "(new)");
+            continue;
+        }
+
+        const auto base_median = calculate_stats(iter->samples).median.count();
+        const auto new_median = calculate_stats(r.samples).median.count();
+        const double change = base_median > 0 ? new_median / base_median - 1.0 : 0.0;
+        const double p = mann_whitney_p(iter->samples, r.samples);
+        const bool significant = p < opts.alpha;
+
+        const double min_p = min_reachable_p(iter->samples.size(), r.samples.size());
+        if (min_p >= opts.alpha) {
+            ++unflaggable;
+            worst_min_p = std::max(worst_min_p, min_p);
+        }
+
+        std::string mem = "-";
+        bool mem_grew = false;
+        if (iter->peak_bytes && r.peak_bytes) {
+            const double base_peak = *iter->peak_bytes;
+            mem = fmt::format("{:+.1f}%", base_peak > 0 ? (*r.peak_bytes / base_peak - 1.0) * 100 : 0.0);
+            mem_grew = *r.peak_bytes > base_peak * (1.0 + opts.threshold) &&
+                       *r.peak_bytes - base_peak >= 4096;
+        }
+
+        std::string verdict;
+        if (significant && change > opts.threshold) {
+            verdict = "SLOWER";
+        } else if (significant && change < -opts.threshold) {
+            verdict = "faster";
+        }
+        if (mem_grew) {
+            verdict += verdict.empty() ? "MORE MEMORY" : ", MORE MEMORY";
+        }
+        if ((significant && change > opts.threshold) || mem_grew) {
+            ++regressions;
+        }
+
+        fmt::print("{:<10} {:<9} {:>11.3f} {:>11.3f} {:>+7.1f}% {:>9.2g} {:>12}  {}\n",
+                   r.name, r.stage, base_median, new_median, change * 100, p, mem, verdict);
+    }
+
+    if (regressions > 0) {
+        fmt::print("\n{} stage(s) regressed\n", regressions);
+    }
+    if (unflaggable > 0) {
+        fmt::print(stderr, "\nWarning: {} stage(s) have too few samples for p < {} to be reachable "
+                           "(smallest possible p = {:.2g}), so their timings can't be flagged; "
+                           "use more --runs\n",
+                   unflaggable, opts.alpha, worst_min_p);
+    }
+    return regressions;
+}
+
+// Runs a day's registered solver and its reference engine (see
+// aoc::register_reference) on the same input, and prints whether each part
+// agrees. Returns the number of parts that didn't.
+int verify_day(const options& opts, const aoc::day_entry& entry, const aoc::day_entry& ref)
+{
+    const auto path = input_path(opts, entry);
+    if (!file_exists(path)) {
+        fmt::print(stderr, "Skipping {}: no input file {}\n", entry.name, path);
+        return 0;
+    }
+
+    const aoc::mapped_file file(path.c_str());
+    const auto input = entry.parse(file.view());
+    const auto ref_input = ref.parse(file.view());
+
+    using part_ptr = std::function<std::string(const std::any&)> aoc::day_entry::*;
+    const std::pair<const char*, part_ptr> parts[] = {
+        {"part_one", &aoc::day_entry::part_one},
+        {"part_two", &aoc::day_entry::part_two}
+    };
+
+    int mismatches = 0;
+    for (const auto& [stage, part] : parts) {
+        if (!(entry.*part) || !(ref.*part)) {
+            continue;
+        }
+
+        std::string result, ref_result;
+        const auto ref_time = time_call([&] { ref_result = (ref.*part)(ref_input); });
+        const auto time = time_call([&] { result = (entry.*part)(input); });
+        const bool same = result == ref_result;
+
+        fmt::print("{:<10} {:<9} {:>11.3f} {:>11.3f}  {}\n", entry.name, stage,
+                   ref_time.count(), time.count(), same ? "ok" : "MISMATCH");
+        if (!same) {
+            fmt::print("  reference: {}\n  got:       {}\n", ref_result, result);
+            ++mismatches;
+        }
+    }
+
+    return mismatches;
+}
+
+int verify(const options& opts)
+{
+    fmt::print("{:<10} {:<9} {:>11} {:>11}\n", "day", "stage", "reference", "registered");
+
+    int mismatches = 0;
+    for (const auto& ref : aoc::reference_registry()) {
+        if (opts.only_day != 0 && ref.day != opts.only_day) {
+            continue;
+        }
+        const auto iter = nano::find(aoc::registry(), ref.name, &aoc::day_entry::name);
+        if (iter == aoc::registry().end()) {
+            continue;
+        }
+
+        try {
+            mismatches += verify_day(opts, *iter, ref);
+        } catch (const std::exception& e) {
+            fmt::print("{:<10} ERROR: {}\n", ref.name, e.what());
+            ++mismatches;
+        }
+    }
+
+    if (mismatches > 0) {
+        fmt::print("\n{} part(s) disagreed with the reference\n", mismatches);
+    }
+    return mismatches;
+}
+
+std::optional<options> parse_args(int argc, char** argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const auto next_int = [&](int& out) {
+            return ++i < argc && aoc::pattern{"{}"}.scan(argv[i], out);
+        };
+
+        if (arg == "--runs" || arg == "-n") {
+            if (!next_int(opts.runs) || opts.runs < 1) return std::nullopt;
+        } else if (arg == "--warmup") {
+            if (!next_int(opts.warmup) || opts.warmup < 0) return std::nullopt;
+        } else if (arg == "--day" || arg == "-d") {
+            if (!next_int(opts.only_day)) return std::nullopt;
+        } else if (arg == "--save-baseline" && ++i < argc) {
+            opts.save_path = argv[i];
+        } else if (arg == "--label" && ++i < argc) {
+            opts.label = argv[i];
+        } else if (arg == "--compare" && ++i < argc) {
+            opts.compare_path = argv[i];
+        } else if (arg == "--parse-cache" && ++i < argc) {
+            opts.parse_cache_dir = argv[i];
+        } else if (arg == "--verify") {
+            opts.verify = true;
+        } else if (arg == "--alpha" && ++i < argc) {
+            const std::string_view val = argv[i];
+            const auto [end, ec] = std::from_chars(val.data(), val.data() + val.size(), opts.alpha);
+            if (ec != std::errc{} || end != val.data() + val.size() ||
+                !(opts.alpha > 0 && opts.alpha < 1)) {
+                return std::nullopt;
+            }
+        } else if (arg == "--threshold" && ++i < argc) {
+            int pct = 0;
+            if (!aoc::pattern{"{}"}.scan(argv[i], pct) || pct < 0) return std::nullopt;
+            opts.threshold = pct / 100.0;
+        } else if (opts.input_dir.empty()) {
+            opts.input_dir = arg;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    if (opts.input_dir.empty()) {
+        return std::nullopt;
+    }
+
+    return opts;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto opts = parse_args(argc, argv);
+    if (!opts) {
+        fmt::print(stderr, "Usage: {} [--runs N] [--warmup N] [--day N]\n"
+                           "           [--save-baseline FILE [--label TEXT]]\n"
+                           "           [--compare FILE [--threshold PERCENT] [--alpha P]] [--parse-cache DIR]\n"
+                           "           <input dir>\n"
+                           "       {} --verify [--day N] <input dir>\n",
+                   argv[0], argv[0]);
+        return 1;
+    }
+
+    if (opts->verify) {
+        return verify(*opts) > 0 ? 3 : 0;
+    }
+
+    if (!opts->parse_cache_dir.empty()) {
+        try {
+            aoc::parse_cache{opts->parse_cache_dir};
+        } catch (const std::exception& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            return 1;
+        }
+    }
+
+    // Load the baseline first, so as not to find out it's bad after the run
+    std::optional<baseline> base;
+    if (!opts->compare_path.empty()) {
+        try {
+            base = load_baseline(opts->compare_path);
+        } catch (const std::exception& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            return 1;
+        }
+    }
+
+    auto days = aoc::registry();
+    nano::sort(days, nano::less<>{}, [](const auto& e) { return std::tie(e.day, e.name); });
+
+    fmt::print("{} runs per stage (+{} warmup), times in ms\n\n", opts->runs, opts->warmup);
+    fmt::print("{:<10} {:<9} {:>10} {:>11} {:>11} {:>11} {:>14}\n",
+               "day", "stage", "input", "min", "median", "p95", "throughput");
+
+    // A day that throws is reported and left out of the results, as with
+    // --verify, rather than ending the run
+    std::vector<stage_result> results;
+    int failures = 0;
+    for (const auto& entry : days) {
+        if (opts->only_day != 0 && entry.day != opts->only_day) {
+            continue;
+        }
+        try {
+            bench_day(*opts, entry, results);
+        } catch (const std::exception& e) {
+            fmt::print("{:<10} ERROR: {}\n", entry.name, e.what());
+            ++failures;
+        }
+    }
+
+    if (!opts->save_path.empty() && !save_baseline(opts->save_path, opts->label, results)) {
+        fmt::print(stderr, "Could not write baseline '{}'\n", opts->save_path);
+        return 1;
+    }
+
+    const bool flagged = base && compare_to_baseline(*opts, *base, results) > 0;
+    if (failures > 0) {
+        fmt::print("\n{} day(s) failed\n", failures);
+        return 4;
+    }
+    if (flagged) {
+        return 2;
+    }
+}
@@ -3,23 +3,4152 @@
 #define ADVENT_OF_CODE_2018_COMMON_HPP
 
 #include <algorithm>
+#include <any>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
 #include <fstream>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <new>
 #include <numeric>
+#include <optional>
+#include <set>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <system_error>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <linux/mempolicy.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#if defined(AOC_PROFILE) && defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+#define AOC_PROFILE_SUPPORTED
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <signal.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#endif
+
 #include "extern/nanorange.hpp"
 
 #define FMT_HEADER_ONLY
 #include "extern/fmt/format.h"
 
+// Compile-time solving. Building a day with -DAOC_EMBED_INPUT=<header>,
+// where the header was generated from an input file by embed/main.cpp,
+// defines aoc::embedded_input as a constexpr string_view of the file's
+// contents. Days whose solvers are constexpr then have the compiler work out
+// their answers, and their main() just prints them; the other parts are
+// solved at run time, from the embedded input rather than a file.
+#ifdef AOC_EMBED_INPUT
+#include AOC_EMBED_INPUT
+#endif
+
+namespace aoc {
+
+// A read-only view of the contents of a file.
+//
+// Regular files are mmap()ed, so the contents are never copied; anything
+// else (pipes, /dev/stdin...) is read into a buffer instead.
+class mapped_file {
+public:
+    mapped_file() = default;
+
+    explicit mapped_file(const char* path)
+    {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error(fmt::format("Could not open '{}'", path));
+        }
+
+        struct ::stat st{};
+        if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size_ = static_cast<size_t>(st.st_size);
+            if (size_ > 0) {
+                void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (addr != MAP_FAILED) {
+                    ::madvise(addr, size_, MADV_SEQUENTIAL);
+                    data_ = static_cast<const char*>(addr);
+                    mapped_ = true;
+                }
+            }
+        }
+
+        const int err = mapped_ ? 0 : read_all(fd);
+        ::close(fd);
+        if (err != 0) {
+            throw std::system_error(err, std::generic_category(),
+                                    fmt::format("Could not read '{}'", path));
+        }
+    }
+
+    mapped_file(mapped_file&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 0)),
+          mapped_(std::exchange(other.mapped_, false)),
+          buffer_(std::move(other.buffer_))
+    {
+        if (!mapped_) {
+            data_ = buffer_.data();
+        }
+    }
+
+    mapped_file& operator=(mapped_file&& other) noexcept
+    {
+        mapped_file(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~mapped_file()
+    {
+        if (mapped_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    std::string_view view() const { return {data_, size_}; }
+    size_t size() const { return size_; }
+
+private:
+    void swap(mapped_file& other) noexcept
+    {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(mapped_, other.mapped_);
+        std::swap(buffer_, other.buffer_);
+        if (!mapped_) {
+            data_ = buffer_.data();
+        }
+        if (!other.mapped_) {
+            other.data_ = other.buffer_.data();
+        }
+    }
+
+    // Returns an errno, or 0
+    int read_all(const int fd)
+    {
+        char buf[65536];
+        while (true) {
+            const ssize_t n = ::read(fd, buf, sizeof(buf));
+            if (n > 0) {
+                buffer_.append(buf, static_cast<size_t>(n));
+            } else if (n == 0) {
+                break;
+            } else if (errno != EINTR) {
+                return errno;
+            }
+        }
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        return 0;
+    }
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
+
+// A forward range over the lines of a string, without the trailing '\n'
+// (or "\r\n"). Empty lines are preserved, but a final newline does not
+// produce an extra empty line.
+class line_range {
+public:
+    struct iterator {
+        using value_type = std::string_view;
+        using reference = std::string_view;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        constexpr iterator() = default;
+
+        constexpr iterator(std::string_view rest)
+            : rest_(rest)
+        {
+            find_line();
+        }
+
+        constexpr std::string_view operator*() const { return line_; }
+
+        constexpr iterator& operator++()
+        {
+            rest_.remove_prefix(nano::min(next_, rest_.size()));
+            find_line();
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend constexpr bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.rest_.data() == rhs.rest_.data();
+        }
+
+        friend constexpr bool operator!=(const iterator& lhs, const iterator& rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        constexpr void find_line()
+        {
+            const auto pos = rest_.find('\n');
+            line_ = rest_.substr(0, pos);
+            next_ = pos == std::string_view::npos ? rest_.size() : pos + 1;
+            if (!line_.empty() && line_.back() == '\r') {
+                line_.remove_suffix(1);
+            }
+        }
+
+        std::string_view rest_{};
+        std::string_view line_{};
+        size_t next_ = 0;
+    };
+
+    constexpr explicit line_range(std::string_view str)
+        : str_(str)
+    {}
+
+    constexpr iterator begin() const { return iterator{str_}; }
+    constexpr iterator end() const { return iterator{str_.substr(str_.size())}; }
+    constexpr bool empty() const { return str_.empty(); }
+
+private:
+    std::string_view str_;
+};
+
+constexpr line_range lines(std::string_view str) { return line_range{str}; }
+
+constexpr bool is_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// A forward range over the whitespace-separated words of a string
+class word_range {
+public:
+    struct iterator {
+        using value_type = std::string_view;
+        using reference = std::string_view;
+        using pointer = void;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        constexpr iterator() = default;
+
+        constexpr iterator(std::string_view rest)
+            : rest_(rest)
+        {
+            find_word();
+        }
+
+        constexpr std::string_view operator*() const { return word_; }
+
+        constexpr iterator& operator++()
+        {
+            rest_.remove_prefix(word_.size());
+            find_word();
+            return *this;
+        }
+
+        constexpr iterator operator++(int)
+        {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend constexpr bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.rest_.data() == rhs.rest_.data();
+        }
+
+        friend constexpr bool operator!=(const iterator& lhs, const iterator& rhs)
+        {
+            return !(lhs == rhs);
+        }
+
+    private:
+        constexpr void find_word()
+        {
+            size_t i = 0;
+            while (i < rest_.size() && is_space(rest_[i])) {
+                ++i;
+            }
+            rest_.remove_prefix(i);
+
+            size_t j = 0;
+            while (j < rest_.size() && !is_space(rest_[j])) {
+                ++j;
+            }
+            word_ = rest_.substr(0, j);
+        }
+
+        std::string_view rest_{};
+        std::string_view word_{};
+    };
+
+    constexpr explicit word_range(std::string_view str)
+        : str_(str)
+    {}
+
+    constexpr iterator begin() const { return iterator{str_}; }
+    constexpr iterator end() const { return iterator{str_.substr(str_.size())}; }
+
+private:
+    std::string_view str_;
+};
+
+constexpr word_range words(std::string_view str) { return word_range{str}; }
+
+// Removes leading and trailing whitespace
+constexpr std::string_view trim(std::string_view str)
+{
+    while (!str.empty() && is_space(str.front())) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && is_space(str.back())) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// Parses a whole string as a decimal integer, with an optional sign. Unlike
+// from_chars() (or pattern, which uses it) this works in constant
+// expressions, for solving embedded inputs at compile time; anything that
+// isn't a digit is simply skipped over, so it's for inputs known to be good.
+template <typename T = int>
+constexpr T parse_int(std::string_view str)
+{
+    bool negative = false;
+    if (!str.empty() && (str.front() == '-' || str.front() == '+')) {
+        negative = str.front() == '-';
+        str.remove_prefix(1);
+    }
+    T value = 0;
+    for (const char c : str) {
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0');
+        }
+    }
+    return negative ? T(-value) : value;
+}
+
+// Parses a whole string as a decimal integer, with an optional sign, as
+// parse_int() does, but checking it: returns nullopt if there is anything
+// else in the string, or the value doesn't fit in a T
+template <typename T = int>
+std::optional<T> try_parse_int(std::string_view str)
+{
+    if (str.size() > 1 && str.front() == '+' && str[1] != '-') {
+        str.remove_prefix(1);
+    }
+    T value{};
+    const auto [end, ec] = std::from_chars(str.data(), str.data() + str.size(), value);
+    if (ec != std::errc{} || str.empty() || end != str.data() + str.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// For the days' parsers, which check what they read so that bad input gets
+// an error (which the server, for one, passes back) rather than a crash or a
+// solver that never finishes
+[[noreturn]] inline void bad_input(std::string_view what)
+{
+    throw std::runtime_error(fmt::format("Bad input: {}", what));
+}
+
+// Returns str as a JSON string literal, quoted and escaped
+inline std::string json_quote(std::string_view str)
+{
+    std::string q = "\"";
+    for (const char c : str) {
+        switch (c) {
+        case '"': q += "\\\""; break;
+        case '\\': q += "\\\\"; break;
+        case '\n': q += "\\n"; break;
+        case '\t': q += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                q += fmt::format("\\u{:04x}", int(c));
+            } else {
+                q += c;
+            }
+        }
+    }
+    return q + '"';
+}
+
+namespace detail {
+
+constexpr void skip_space(std::string_view& in)
+{
+    while (!in.empty() && is_space(in.front())) {
+        in.remove_prefix(1);
+    }
+}
+
+template <typename T>
+bool scan_field(std::string_view& in, T& out, const char stop)
+{
+    skip_space(in);
+
+    if constexpr (std::is_same_v<T, char>) {
+        if (in.empty()) {
+            return false;
+        }
+        out = in.front();
+        in.remove_prefix(1);
+        return true;
+    } else if constexpr (std::is_same_v<T, std::string_view>) {
+        size_t i = 0;
+        while (i < in.size() && !is_space(in[i]) && in[i] != stop) {
+            ++i;
+        }
+        out = in.substr(0, i);
+        in.remove_prefix(i);
+        return i > 0;
+    } else if constexpr (std::is_enum_v<T>) {
+        std::underlying_type_t<T> i{};
+        if (!scan_field(in, i, stop)) {
+            return false;
+        }
+        out = T{i};
+        return true;
+    } else {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                      "Unsupported field type");
+        // from_chars() doesn't accept a leading '+'; as in try_parse_int(),
+        // "+-5" mustn't become -5
+        if (in.size() > 1 && in.front() == '+' && in[1] != '-') {
+            in.remove_prefix(1);
+        }
+        const auto [ptr, ec] = std::from_chars(in.data(), in.data() + in.size(), out);
+        if (ec != std::errc{}) {
+            return false;
+        }
+        in.remove_prefix(ptr - in.data());
+        return true;
+    }
+}
+
+}
+
+// A sscanf() replacement for fixed line formats.
+//
+// Each "{}" in the pattern is a field, and everything else is literal text
+// which must match exactly, except that whitespace in the pattern matches any
+// amount (including none) of whitespace in the input. Like scanf(), fields
+// skip leading whitespace. Fields can be integers (parsed with from_chars()),
+// enums, single chars or string_views (which stop at whitespace or at the
+// next literal character).
+//
+// The pattern is split up when the object is constructed, so declaring it
+// constexpr means that there is no format string interpretation at run time:
+//
+//     constexpr aoc::pattern claim_pattern{"#{} @ {},{}: {}x{}"};
+//     claim_pattern.scan(line, id, left, top, width, height);
+class pattern {
+public:
+    static constexpr size_t max_fields = 8;
+
+    constexpr explicit pattern(std::string_view str)
+    {
+        size_t pos = 0;
+        while (true) {
+            const auto next = str.find("{}", pos);
+            literals_[num_fields_] = str.substr(pos, next - pos);
+            if (next == std::string_view::npos) {
+                break;
+            }
+            ++num_fields_;
+            assert(num_fields_ <= max_fields);
+            pos = next + 2;
+        }
+    }
+
+    constexpr size_t num_fields() const { return num_fields_; }
+
+    // Returns true if the whole pattern was matched. As with sscanf(),
+    // any input after the end of the pattern is ignored.
+    template <typename... Fields>
+    bool scan(std::string_view in, Fields&... fields) const
+    {
+        assert(sizeof...(Fields) == num_fields_);
+        size_t idx = 0;
+        return match_literal(in, idx) &&
+               (... && (detail::scan_field(in, fields, stop_char(idx)) &&
+                        match_literal(in, idx)));
+    }
+
+    // As scan(), but throws std::runtime_error quoting the input if the
+    // pattern doesn't match
+    template <typename... Fields>
+    void scan_or_throw(std::string_view in, Fields&... fields) const
+    {
+        if (!scan(in, fields...)) {
+            constexpr size_t max_quoted = 80;
+            bad_input(fmt::format("'{}{}'", in.substr(0, max_quoted),
+                                  in.size() > max_quoted ? "..." : ""));
+        }
+    }
+
+private:
+    constexpr char stop_char(size_t idx) const
+    {
+        const auto lit = literals_[idx];
+        return lit.empty() ? '\0' : lit.front();
+    }
+
+    bool match_literal(std::string_view& in, size_t& idx) const
+    {
+        for (const char c : literals_[idx++]) {
+            if (is_space(c)) {
+                detail::skip_space(in);
+            } else if (!in.empty() && in.front() == c) {
+                in.remove_prefix(1);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::array<std::string_view, max_fields + 1> literals_{};
+    size_t num_fields_ = 0;
+};
+
+// Lightweight instrumentation, enabled by compiling with -DAOC_INSTRUMENT.
+// Without it, all of the macros below compile to nothing.
+//
+//   AOC_PHASE("name")        starts a named phase, lasting until the end of
+//                            the enclosing scope
+//   AOC_SCOPED_TIMER("name") times the enclosing scope
+//   AOC_COUNT("name", n)     adds n to a named counter
+//
+// Timers and counters are global, and each phase is credited with whatever
+// they accumulated while it was running (so an inner phase's figures are
+// also included in the outer one's). On Linux, each phase also records the
+// hardware counters below for the thread that ran it and for any thread pool
+// tasks it handed out. A JSON report of every phase is written when the
+// program exits, to the file named by the AOC_INSTRUMENT_OUT environment
+// variable, or to stderr.
+//
+// Compiling with -DAOC_TRACK_ALLOCS as well (it implies AOC_INSTRUMENT)
+// replaces the global operator new and delete with counting versions, and
+// each phase then reports the number of allocations, the bytes allocated
+// and the peak live bytes above its starting point. These are counted over
+// the whole process, so a phase which overlaps another on a different thread
+// (as concurrent jobs in the server do) includes the other's allocations.
+// The replacements are defined in the translation unit that doesn't define
+// AOC_NO_MAIN, so programs linking several days together must #undef it in
+// the file containing their own main().
+//
+// Compiling with -DAOC_PROFILE (which also implies AOC_INSTRUMENT) turns on
+// the sampling profiler below, which writes a flame graph's worth of stacks
+// for each phase at exit.
+#if (defined(AOC_TRACK_ALLOCS) || defined(AOC_PROFILE)) && !defined(AOC_INSTRUMENT)
+#define AOC_INSTRUMENT
+#endif
+
+namespace instr {
+
+#ifdef AOC_INSTRUMENT
+inline constexpr bool enabled = true;
+#else
+inline constexpr bool enabled = false;
+#endif
+
+using clock = std::chrono::steady_clock;
+
+// Roughly when the program started, as the origin for traces
+inline const clock::time_point start_time = clock::now();
+
+struct metric {
+    enum kind_t { counter, timer };
+
+    std::string name;
+    kind_t kind = counter;
+    std::atomic<uint64_t> value{0}; // count, or total nanoseconds
+    std::atomic<uint64_t> calls{0};
+};
+
+// Hardware counters for the calling thread, read with perf_event_open(2).
+// If the kernel won't allow it (see /proc/sys/kernel/perf_event_paranoid)
+// or there is no PMU, available() is false and phases report no hardware
+// figures. Events the CPU doesn't support are left out individually.
+//
+// The counters only see their own thread, so work a phase hands to the
+// thread pool is counted by the pool: each task run on another thread adds
+// what it counted there to the sink of the phase that submitted it.
+class hw_counters {
+public:
+    static constexpr size_t num_events = 4;
+    static constexpr std::array<const char*, num_events> names{
+        "cycles", "instructions", "cache_misses", "branch_misses"
+    };
+
+    struct values {
+        std::array<uint64_t, num_events> counts{};
+        std::array<bool, num_events> valid{};
+    };
+
+    // Counts run up on other threads on behalf of a phase
+    struct sink {
+        std::array<std::atomic<uint64_t>, num_events> counts{};
+
+        void add(const values& before, const values& after)
+        {
+            for (size_t i = 0; i < num_events; i++) {
+                if (before.valid[i] && after.valid[i]) {
+                    counts[i].fetch_add(after.counts[i] - before.counts[i], std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    static hw_counters& this_thread()
+    {
+        thread_local hw_counters c;
+        return c;
+    }
+
+    // The sink of this thread's innermost phase, or of the phase whose pool
+    // task it is running
+    static sink*& current_sink()
+    {
+        thread_local sink* s = nullptr;
+        return s;
+    }
+
+    hw_counters(const hw_counters&) = delete;
+    hw_counters& operator=(const hw_counters&) = delete;
+
+    ~hw_counters()
+    {
+        for (const int fd : fds_) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+    bool available() const { return fds_[0] >= 0; }
+
+    // Counts so far, scaled up if the kernel had to multiplex the counters
+    values read() const
+    {
+        values out;
+#ifdef __linux__
+        if (!available()) {
+            return out;
+        }
+
+        // See "Reading results" in perf_event_open(2)
+        std::array<uint64_t, 3 + num_events> buf{};
+        if (::read(fds_[0], buf.data(), sizeof(buf)) < 0) {
+            return out;
+        }
+        const auto [nr, enabled, running] = std::tuple(buf[0], buf[1], buf[2]);
+        const double scale = running > 0 ? double(enabled) / running : 1.0;
+
+        size_t idx = 3;
+        for (size_t i = 0; i < num_events && idx < 3 + nr; i++) {
+            if (fds_[i] >= 0) {
+                out.counts[i] = static_cast<uint64_t>(buf[idx++] * scale);
+                out.valid[i] = true;
+            }
+        }
+#endif
+        return out;
+    }
+
+private:
+    hw_counters()
+    {
+        fds_.fill(-1);
+#ifdef __linux__
+        constexpr std::array<uint64_t, num_events> configs{
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (size_t i = 0; i < num_events; i++) {
+            ::perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[i];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            const int fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, fds_[0], 0);
+            if (i == 0 && fd < 0) {
+                return;
+            }
+            fds_[i] = fd;
+        }
+#endif
+    }
+
+    std::array<int, num_events> fds_;
+};
+
+// Updated by the replacement operator new and delete
+struct alloc_stats {
+#ifdef AOC_TRACK_ALLOCS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    static inline std::atomic<uint64_t> allocations{0};
+    static inline std::atomic<uint64_t> bytes{0};
+    static inline std::atomic<uint64_t> live{0};
+
+    // The peaks of the running phases, one slot each: the highest live size
+    // seen since the phase began. Each bit of active marks a slot in use.
+    // Phases take a slot of their own rather than sharing one peak, so that
+    // those running at the same time on different threads can't reset each
+    // other's.
+    static constexpr size_t max_phases = 64;
+    static inline std::array<std::atomic<uint64_t>, max_phases> peaks{};
+    static inline std::atomic<uint64_t> active{0};
+
+    static void on_alloc(size_t size)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        const auto now = live.fetch_add(size, std::memory_order_relaxed) + size;
+        for (auto mask = active.load(std::memory_order_acquire); mask != 0; mask &= mask - 1) {
+            auto& peak = peaks[lowest_bit(mask)];
+            auto old_peak = peak.load(std::memory_order_relaxed);
+            while (now > old_peak &&
+                   !peak.compare_exchange_weak(old_peak, now, std::memory_order_relaxed)) {}
+        }
+    }
+
+    static void on_free(size_t size)
+    {
+        live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    // Counts at the start of a phase, and the phase's peak slot (or
+    // max_phases if they were all taken, when no peak is reported)
+    struct sample {
+        uint64_t allocations = 0;
+        uint64_t bytes = 0;
+        uint64_t live = 0;
+        size_t slot = max_phases;
+    };
+
+    static sample begin_phase()
+    {
+        sample s;
+        s.allocations = allocations.load(std::memory_order_relaxed);
+        s.bytes = bytes.load(std::memory_order_relaxed);
+        s.live = live.load(std::memory_order_relaxed);
+
+        auto used = active.load(std::memory_order_relaxed);
+        while (~used != 0) {
+            const size_t slot = lowest_bit(~used);
+            peaks[slot].store(s.live, std::memory_order_relaxed);
+            if (active.compare_exchange_weak(used, used | (uint64_t{1} << slot),
+                                             std::memory_order_acq_rel)) {
+                s.slot = slot;
+                break;
+            }
+        }
+        return s;
+    }
+
+    // Returns (allocations, bytes, peak bytes above the starting live size).
+    // These are for the whole process, so phases which overlap on other
+    // threads include each other's allocations.
+    static std::tuple<uint64_t, uint64_t, uint64_t> end_phase(const sample& before)
+    {
+        const auto allocs = allocations.load(std::memory_order_relaxed) - before.allocations;
+        const auto total = bytes.load(std::memory_order_relaxed) - before.bytes;
+        uint64_t phase_peak = 0;
+        if (before.slot < max_phases) {
+            phase_peak = peaks[before.slot].load(std::memory_order_relaxed);
+            active.fetch_and(~(uint64_t{1} << before.slot), std::memory_order_acq_rel);
+        }
+        return {allocs, total, phase_peak > before.live ? phase_peak - before.live : 0};
+    }
+
+private:
+    static size_t lowest_bit(uint64_t mask)
+    {
+        size_t i = 0;
+        while (!(mask & 1)) {
+            mask >>= 1;
+            ++i;
+        }
+        return i;
+    }
+};
+
+// A sampling profiler, enabled by compiling with -DAOC_PROFILE. A timer set
+// with setitimer(ITIMER_PROF) raises SIGPROF for every millisecond of CPU
+// time the process uses (or 1/AOC_PROFILE_HZ seconds), and the handler walks
+// the frame pointers of whichever thread it interrupted, storing the return
+// addresses in a ring buffer. Memory is read with process_vm_readv(), so that
+// a bad frame pointer ends the walk rather than crashing, which keeps the
+// handler async-signal-safe. A background thread drains the buffer every
+// 50ms, as do the ends of phases and exit, so that long phases and busy
+// thread pools don't fill it and lose samples.
+//
+// Each stack is credited to the innermost phase running on the thread it
+// was taken on. Phases nest per thread, so concurrent jobs (as in the
+// server's batch mode) each keep their own; thread pool tasks and
+// record_stream producers take on the phase of the thread that started
+// them. At exit the stacks are symbolised from the executable's symbol
+// table and written, one "phase;outer;...;inner count" line each, in the
+// folded format that flamegraph.pl and speedscope read. They go to the file
+// named by AOC_PROFILE_OUT, or else aoc-profile.folded.
+//
+// Stacks stop at the first function without a frame pointer, so build with
+// -fno-omit-frame-pointer. Only x86-64 and AArch64 Linux are supported;
+// elsewhere nothing is sampled.
+#ifdef AOC_PROFILE_SUPPORTED
+class profiler {
+public:
+    static constexpr bool enabled = true;
+    static constexpr size_t max_depth = 64;
+    static constexpr size_t capacity = 4096;
+    static constexpr auto drain_interval = std::chrono::milliseconds(50);
+
+    static profiler& get()
+    {
+        static profiler p;
+        return p;
+    }
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    ~profiler()
+    {
+        ::itimerval off{};
+        ::setitimer(ITIMER_PROF, &off, nullptr);
+        ::signal(SIGPROF, SIG_IGN);
+        instance_ = nullptr;
+        {
+            std::lock_guard lock(drainer_mutex_);
+            stopping_ = true;
+        }
+        drainer_cv_.notify_one();
+        drainer_.join();
+        drain();
+        write_profile();
+    }
+
+    // Credits this thread's samples to the named phase until leave_phase()
+    // is called with the id this returns
+    uint32_t enter_phase(std::string_view name)
+    {
+        std::lock_guard lock(mutex_);
+        auto iter = nano::find(phase_names_, name);
+        if (iter == phase_names_.end()) {
+            iter = phase_names_.insert(iter, std::string(name));
+        }
+        const auto id = static_cast<uint32_t>(iter - phase_names_.begin());
+        return current_phase_.exchange(id, std::memory_order_relaxed);
+    }
+
+    void leave_phase(uint32_t previous)
+    {
+        drain();
+        current_phase_.store(previous, std::memory_order_relaxed);
+    }
+
+    // The id of this thread's innermost phase, for handing to another thread
+    uint32_t current_phase() const
+    {
+        return current_phase_.load(std::memory_order_relaxed);
+    }
+
+    // Credits this thread's samples to a phase entered on another thread,
+    // returning the id to put back afterwards
+    uint32_t adopt_phase(uint32_t id)
+    {
+        return current_phase_.exchange(id, std::memory_order_relaxed);
+    }
+
+private:
+    struct sample_slot {
+        std::atomic<bool> ready{false};
+        uint32_t phase = 0;
+        uint32_t depth = 0;
+        std::array<uintptr_t, max_depth> pcs;
+    };
+
+    profiler()
+    {
+        int hz = 1000;
+        if (const char* env = std::getenv("AOC_PROFILE_HZ")) {
+            hz = std::clamp(std::atoi(env), 1, 100000);
+        }
+
+        instance_ = this;
+        struct ::sigaction sa{};
+        sa.sa_sigaction = on_signal;
+        sa.sa_flags = SA_SIGINFO | SA_RESTART;
+        ::sigemptyset(&sa.sa_mask);
+        ::sigaction(SIGPROF, &sa, nullptr);
+
+        ::itimerval timer{};
+        timer.it_interval.tv_usec = 1'000'000 / hz;
+        timer.it_value = timer.it_interval;
+        ::setitimer(ITIMER_PROF, &timer, nullptr);
+
+        drainer_ = std::thread([this] {
+            std::unique_lock lock(drainer_mutex_);
+            while (!drainer_cv_.wait_for(lock, drain_interval, [this] { return stopping_; })) {
+                lock.unlock();
+                drain();
+                lock.lock();
+            }
+        });
+    }
+
+    static bool read_frame(uintptr_t addr, std::array<uintptr_t, 2>& frame)
+    {
+        ::iovec local{frame.data(), sizeof(frame)};
+        ::iovec remote{reinterpret_cast<void*>(addr), sizeof(frame)};
+        return ::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0) == ssize_t(sizeof(frame));
+    }
+
+    static void on_signal(int, ::siginfo_t*, void* context)
+    {
+        profiler* const self = instance_;
+        if (!self) {
+            return;
+        }
+        const int saved_errno = errno;
+
+        // Claim a slot, unless the buffer is full
+        auto pos = self->write_pos_.load(std::memory_order_relaxed);
+        do {
+            if (pos - self->read_pos_.load(std::memory_order_acquire) >= capacity) {
+                self->dropped_.fetch_add(1, std::memory_order_relaxed);
+                errno = saved_errno;
+                return;
+            }
+        } while (!self->write_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed));
+        auto& slot = self->slots_[pos % capacity];
+
+        const auto& mc = static_cast<::ucontext_t*>(context)->uc_mcontext;
+#if defined(__x86_64__)
+        uintptr_t pc = mc.gregs[REG_RIP];
+        uintptr_t fp = mc.gregs[REG_RBP];
+#else
+        uintptr_t pc = mc.pc;
+        uintptr_t fp = mc.regs[29];
+#endif
+
+        // Each frame record holds the caller's frame pointer, then the
+        // return address. Stacks grow down, so callers' records are higher.
+        slot.phase = current_phase_.load(std::memory_order_relaxed);
+        slot.pcs[0] = pc;
+        uint32_t depth = 1;
+        std::array<uintptr_t, 2> frame{};
+        while (depth < max_depth && fp != 0 && fp % sizeof(uintptr_t) == 0 && read_frame(fp, frame)) {
+            if (frame[1] == 0) {
+                break;
+            }
+            slot.pcs[depth++] = frame[1];
+            if (frame[0] <= fp) {
+                break;
+            }
+            fp = frame[0];
+        }
+        slot.depth = depth;
+        slot.ready.store(true, std::memory_order_release);
+
+        errno = saved_errno;
+    }
+
+    // Moves finished samples out of the ring buffer into the stack counts
+    void drain()
+    {
+        std::lock_guard lock(drain_mutex_);
+        while (true) {
+            const auto pos = read_pos_.load(std::memory_order_relaxed);
+            if (pos == write_pos_.load(std::memory_order_acquire)) {
+                break;
+            }
+            auto& slot = slots_[pos % capacity];
+            if (!slot.ready.load(std::memory_order_acquire)) {
+                break; // still being written
+            }
+
+            // The phase, then the addresses from the outermost frame inwards
+            std::vector<uintptr_t> stack;
+            stack.reserve(slot.depth + 1);
+            stack.push_back(slot.phase);
+            stack.insert(stack.end(), std::make_reverse_iterator(slot.pcs.begin() + slot.depth),
+                         std::make_reverse_iterator(slot.pcs.begin()));
+            ++stacks_[std::move(stack)];
+
+            slot.ready.store(false, std::memory_order_relaxed);
+            read_pos_.store(pos + 1, std::memory_order_release);
+        }
+    }
+
+    // Function names from the executable's own symbol table, which (unlike
+    // dladdr()) includes functions with internal linkage, as most of the
+    // solvers are. Addresses elsewhere fall back to dladdr().
+    class symbolizer {
+    public:
+        symbolizer()
+        {
+            ::dl_iterate_phdr([](::dl_phdr_info* info, size_t, void* data) {
+                *static_cast<uintptr_t*>(data) = info->dlpi_addr;
+                return 1; // the executable comes first
+            }, &bias_);
+
+            try {
+                exe_ = mapped_file("/proc/self/exe");
+            } catch (const std::exception&) {
+                return;
+            }
+            const auto bytes = exe_.view();
+            if (bytes.size() < sizeof(Elf64_Ehdr) || bytes.substr(0, SELFMAG) != ELFMAG ||
+                bytes[EI_CLASS] != ELFCLASS64) {
+                return;
+            }
+            const auto& ehdr = *reinterpret_cast<const Elf64_Ehdr*>(bytes.data());
+            if (ehdr.e_shoff + size_t(ehdr.e_shnum) * sizeof(Elf64_Shdr) > bytes.size()) {
+                return;
+            }
+            const auto* sections = reinterpret_cast<const Elf64_Shdr*>(bytes.data() + ehdr.e_shoff);
+
+            for (size_t i = 0; i < ehdr.e_shnum; i++) {
+                const auto& sec = sections[i];
+                if (sec.sh_type != SHT_SYMTAB || sec.sh_link >= ehdr.e_shnum ||
+                    sec.sh_offset + sec.sh_size > bytes.size()) {
+                    continue;
+                }
+                const auto& strtab = sections[sec.sh_link];
+                if (strtab.sh_offset + strtab.sh_size > bytes.size()) {
+                    continue;
+                }
+                const auto* syms = reinterpret_cast<const Elf64_Sym*>(bytes.data() + sec.sh_offset);
+                for (size_t j = 0; j < sec.sh_size / sizeof(Elf64_Sym); j++) {
+                    const auto& sym = syms[j];
+                    if (ELF64_ST_TYPE(sym.st_info) == STT_FUNC && sym.st_value != 0 &&
+                        sym.st_name < strtab.sh_size) {
+                        symbols_.push_back({sym.st_value, sym.st_size,
+                                            bytes.data() + strtab.sh_offset + sym.st_name});
+                    }
+                }
+            }
+            nano::sort(symbols_, nano::less<>{}, &symbol::addr);
+        }
+
+        std::string name(uintptr_t pc) const
+        {
+            const auto addr = pc - bias_;
+            auto iter = nano::upper_bound(symbols_, addr, nano::less<>{}, &symbol::addr);
+            if (iter != symbols_.begin() && addr < (--iter)->addr + std::max<uint64_t>(iter->size, 1)) {
+                return demangle(iter->name);
+            }
+
+            ::Dl_info info{};
+            if (::dladdr(reinterpret_cast<void*>(pc), &info) != 0) {
+                if (info.dli_sname) {
+                    return demangle(info.dli_sname);
+                }
+                if (info.dli_fname) {
+                    std::string_view file = info.dli_fname;
+                    file.remove_prefix(nano::min(file.rfind('/') + 1, file.size()));
+                    return fmt::format("{}+{:#x}", file, pc - uintptr_t(info.dli_fbase));
+                }
+            }
+            return fmt::format("{:#x}", pc);
+        }
+
+    private:
+        struct symbol {
+            uint64_t addr;
+            uint64_t size;
+            const char* name;
+        };
+
+        static std::string demangle(const char* name)
+        {
+            int status = 0;
+            std::unique_ptr<char, void (*)(void*)> out(
+                abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+            std::string str = status == 0 ? out.get() : name;
+            // Semicolons separate frames in the output
+            std::replace(str.begin(), str.end(), ';', ':');
+            return str;
+        }
+
+        uintptr_t bias_ = 0;
+        mapped_file exe_;
+        std::vector<symbol> symbols_;
+    };
+
+    void write_profile()
+    {
+        if (stacks_.empty()) {
+            return;
+        }
+        const char* path = std::getenv("AOC_PROFILE_OUT");
+        if (!path) {
+            path = "aoc-profile.folded";
+        }
+        std::FILE* out = std::fopen(path, "w");
+        if (!out) {
+            fmt::print(stderr, "Could not write profile '{}'\n", path);
+            return;
+        }
+
+        const symbolizer sym;
+        std::map<uintptr_t, std::string> names;
+        const auto name_of = [&](uintptr_t pc, bool is_leaf) -> const std::string& {
+            // Return addresses point after the call, which may be the start
+            // of the next function
+            const auto lookup = is_leaf ? pc : pc - 1;
+            auto iter = names.find(lookup);
+            if (iter == names.end()) {
+                iter = names.emplace(lookup, sym.name(lookup)).first;
+            }
+            return iter->second;
+        };
+
+        // Stacks through different addresses in the same functions merge
+        std::map<std::string, uint64_t> folded;
+        for (const auto& [stack, count] : stacks_) {
+            std::string line = phase_names_[stack[0]];
+            for (size_t i = 1; i < stack.size(); i++) {
+                line += ';';
+                line += name_of(stack[i], i == stack.size() - 1);
+            }
+            folded[std::move(line)] += count;
+        }
+        for (const auto& [line, count] : folded) {
+            fmt::print(out, "{} {}\n", line, count);
+        }
+        std::fclose(out);
+
+        if (const auto dropped = dropped_.load()) {
+            fmt::print(stderr, "Profiler dropped {} samples with its buffer full\n", dropped);
+        }
+    }
+
+    static inline std::atomic<profiler*> instance_{nullptr};
+
+    std::array<sample_slot, capacity> slots_;
+    std::atomic<uint64_t> write_pos_{0};
+    std::atomic<uint64_t> read_pos_{0};
+    std::atomic<uint64_t> dropped_{0};
+    // Constant-initialised, so the signal handler can read it
+    static inline thread_local std::atomic<uint32_t> current_phase_{0};
+
+    std::mutex mutex_;
+    std::vector<std::string> phase_names_{"(no phase)"};
+    std::mutex drain_mutex_;
+    std::map<std::vector<uintptr_t>, uint64_t> stacks_;
+
+    // The background drain, which the destructor stops
+    std::thread drainer_;
+    std::mutex drainer_mutex_;
+    std::condition_variable drainer_cv_;
+    bool stopping_ = false;
+};
+
+// Start sampling at static initialisation, so that every run is profiled
+inline const bool profiler_started = (profiler::get(), true);
+#else
+class profiler {
+public:
+    static constexpr bool enabled = false;
+
+    static profiler& get()
+    {
+        static profiler p;
+        return p;
+    }
+
+    uint32_t enter_phase(std::string_view) { return 0; }
+    void leave_phase(uint32_t) {}
+    uint32_t current_phase() const { return 0; }
+    uint32_t adopt_phase(uint32_t) { return 0; }
+};
+#endif
+
+struct phase_record {
+    uint64_t calls = 0;
+    uint64_t total_ns = 0;
+    hw_counters::values hw;
+    uint64_t allocations = 0;
+    uint64_t alloc_bytes = 0;
+    uint64_t peak_bytes = 0; // the highest of any call
+    // Keyed by stat kind and name, as a counter and a timer may share a
+    // name: (value, calls)
+    std::map<std::pair<metric::kind_t, std::string>, std::pair<uint64_t, uint64_t>> stats;
+};
+
+class state {
+public:
+    static state& get()
+    {
+        static state s;
+        return s;
+    }
+
+    metric& get_metric(std::string_view name, metric::kind_t kind)
+    {
+        std::lock_guard lock(mutex_);
+        for (auto& s : stats_) {
+            if (s.name == name && s.kind == kind) {
+                return s;
+            }
+        }
+        auto& s = stats_.emplace_back();
+        s.name = name;
+        s.kind = kind;
+        return s;
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> snapshot()
+    {
+        std::lock_guard lock(mutex_);
+        std::vector<std::pair<uint64_t, uint64_t>> out;
+        out.reserve(stats_.size());
+        for (const auto& s : stats_) {
+            out.emplace_back(s.value.load(std::memory_order_relaxed),
+                             s.calls.load(std::memory_order_relaxed));
+        }
+        return out;
+    }
+
+    void end_phase(std::string_view name, clock::duration elapsed,
+                   const hw_counters::values& hw_before,
+                   const hw_counters::values& hw_after,
+                   const std::tuple<uint64_t, uint64_t, uint64_t>& allocs,
+                   const std::vector<std::pair<uint64_t, uint64_t>>& before)
+    {
+        const auto after = snapshot();
+        std::lock_guard lock(mutex_);
+        auto& rec = phases_[std::string(name)];
+        ++rec.calls;
+        rec.total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        rec.allocations += std::get<0>(allocs);
+        rec.alloc_bytes += std::get<1>(allocs);
+        rec.peak_bytes = std::max(rec.peak_bytes, std::get<2>(allocs));
+
+        for (size_t i = 0; i < hw_counters::num_events; i++) {
+            if (hw_before.valid[i] && hw_after.valid[i]) {
+                rec.hw.counts[i] += hw_after.counts[i] - hw_before.counts[i];
+                rec.hw.valid[i] = true;
+            }
+        }
+
+        auto iter = stats_.begin();
+        for (size_t i = 0; i < after.size(); ++i, ++iter) {
+            const auto [b_val, b_calls] = i < before.size() ? before[i] : std::pair<uint64_t, uint64_t>{};
+            if (after[i].second != b_calls) {
+                auto& [val, calls] = rec.stats[{iter->kind, iter->name}];
+                val += after[i].first - b_val;
+                calls += after[i].second - b_calls;
+            }
+        }
+    }
+
+    void write_report(std::FILE* out)
+    {
+        const auto quote = json_quote;
+
+        std::lock_guard lock(mutex_);
+        fmt::print(out, "{{\n  \"phases\": [");
+        const char* sep = "";
+        for (const auto& [name, rec] : phases_) {
+            fmt::print(out, "{}\n    {{\"name\": {}, \"calls\": {}, \"total_ms\": {:.3f}",
+                       sep, quote(name), rec.calls, rec.total_ns / 1e6);
+            for (const auto kind : {metric::counter, metric::timer}) {
+                fmt::print(out, kind == metric::counter ? ",\n     \"counters\": {{" : ",\n     \"timers\": {{");
+                const char* sep2 = "";
+                for (const auto& [key, vc] : rec.stats) {
+                    const auto& [stat_kind, stat_name] = key;
+                    if (stat_kind != kind) {
+                        continue;
+                    }
+                    if (kind == metric::counter) {
+                        fmt::print(out, "{}{}: {}", sep2, quote(stat_name), vc.first);
+                    } else {
+                        fmt::print(out, "{}{}: {{\"calls\": {}, \"total_ms\": {:.3f}}}",
+                                   sep2, quote(stat_name), vc.second, vc.first / 1e6);
+                    }
+                    sep2 = ", ";
+                }
+                fmt::print(out, "}}");
+            }
+            if (nano::any_of(rec.hw.valid, [](bool b) { return b; })) {
+                fmt::print(out, ",\n     \"hardware\": {{");
+                const char* sep2 = "";
+                for (size_t i = 0; i < hw_counters::num_events; i++) {
+                    if (rec.hw.valid[i]) {
+                        fmt::print(out, "{}\"{}\": {}", sep2, hw_counters::names[i], rec.hw.counts[i]);
+                        sep2 = ", ";
+                    }
+                }
+                if (rec.hw.valid[0] && rec.hw.valid[1] && rec.hw.counts[0] > 0) {
+                    fmt::print(out, ", \"ipc\": {:.3f}", double(rec.hw.counts[1]) / rec.hw.counts[0]);
+                }
+                fmt::print(out, "}}");
+            }
+            if (alloc_stats::enabled) {
+                fmt::print(out, ",\n     \"memory\": {{\"allocations\": {}, \"bytes\": {}, \"peak_bytes\": {}}}",
+                           rec.allocations, rec.alloc_bytes, rec.peak_bytes);
+            }
+            fmt::print(out, "}}");
+            sep = ",";
+        }
+        fmt::print(out, "\n  ]\n}}\n");
+    }
+
+    ~state()
+    {
+        if (phases_.empty()) {
+            return;
+        }
+        if (const char* path = std::getenv("AOC_INSTRUMENT_OUT")) {
+            if (std::FILE* f = std::fopen(path, "w")) {
+                write_report(f);
+                std::fclose(f);
+                return;
+            }
+        }
+        write_report(stderr);
+    }
+
+private:
+    state() = default;
+
+    std::mutex mutex_;
+    std::deque<metric> stats_; // a deque, so that references stay valid
+    std::map<std::string, phase_record> phases_;
+};
+
+// Timeline tracing, for seeing how work is spread across threads. With
+// AOC_INSTRUMENT, running with the AOC_TRACE_OUT environment variable set
+// records every phase, scoped timer and thread pool task as an event on the
+// thread that ran it, and writes them all to that file at exit as Chrome
+// trace_event JSON (which chrome://tracing and ui.perfetto.dev load). Each
+// thread appends to a buffer of its own, so recording takes no locks.
+//
+// Timelines that aren't in real time, such as dec7's simulated workers, can
+// be added with add_timeline() and add_event(). Each shows up as a process
+// of its own, with a lane per named worker.
+class tracer {
+public:
+    using time_point = clock::time_point;
+    using duration = std::chrono::duration<double, std::micro>;
+
+    static tracer& get()
+    {
+        static tracer t;
+        return t;
+    }
+
+    tracer(const tracer&) = delete;
+    tracer& operator=(const tracer&) = delete;
+
+    ~tracer()
+    {
+        if (enabled_) {
+            write_trace();
+        }
+    }
+
+    bool enabled() const { return enabled_; }
+
+    // Records that the calling thread spent [start, end) on name, which must
+    // outlive the tracer (see intern())
+    void record(std::string_view name, time_point start, time_point end, int64_t items = -1)
+    {
+        auto& buf = this_thread();
+        buf.events.push_back({name, start, end, items});
+    }
+
+    // Returns a copy of name which lasts as long as the tracer
+    std::string_view intern(std::string_view name)
+    {
+        std::lock_guard lock(mutex_);
+        return *names_.emplace(name).first;
+    }
+
+    void name_thread(std::string name)
+    {
+        auto& buf = this_thread();
+        std::lock_guard lock(mutex_);
+        buf.name = std::move(name);
+    }
+
+    int add_timeline(std::string name)
+    {
+        std::lock_guard lock(mutex_);
+        timelines_.push_back({std::move(name), {}, {}});
+        return int(timelines_.size() - 1);
+    }
+
+    void add_event(int timeline, std::string_view lane, std::string_view name,
+                   duration start, duration length)
+    {
+        std::lock_guard lock(mutex_);
+        auto& tl = timelines_.at(timeline);
+        auto iter = nano::find(tl.lanes, lane);
+        if (iter == tl.lanes.end()) {
+            iter = tl.lanes.insert(iter, std::string(lane));
+        }
+        tl.events.push_back({std::string(name), int(iter - tl.lanes.begin()), start, length});
+    }
+
+private:
+    struct event {
+        std::string_view name;
+        time_point start;
+        time_point end;
+        int64_t items;
+    };
+
+    struct thread_buffer {
+        std::string name;
+        std::vector<event> events;
+    };
+
+    struct simulated_event {
+        std::string name;
+        int lane;
+        duration start;
+        duration length;
+    };
+
+    struct timeline {
+        std::string name;
+        std::vector<std::string> lanes;
+        std::vector<simulated_event> events;
+    };
+
+    tracer()
+        : start_(start_time)
+    {
+        if (const char* path = std::getenv("AOC_TRACE_OUT"); path && instr::enabled) {
+            path_ = path;
+            enabled_ = true;
+        }
+    }
+
+    thread_buffer& this_thread()
+    {
+        thread_local thread_buffer* buf = nullptr;
+        if (!buf) {
+            std::lock_guard lock(mutex_);
+            buf = buffers_.emplace_back(std::make_unique<thread_buffer>()).get();
+        }
+        return *buf;
+    }
+
+    void write_trace()
+    {
+        std::FILE* out = std::fopen(path_.c_str(), "w");
+        if (!out) {
+            fmt::print(stderr, "Could not write trace '{}'\n", path_);
+            return;
+        }
+
+        std::lock_guard lock(mutex_);
+        const auto us = [this](time_point t) {
+            return std::chrono::duration<double, std::micro>(t - start_).count();
+        };
+        const int pid = ::getpid();
+        const char* sep = "\n";
+
+        fmt::print(out, "{{\"traceEvents\": [");
+        fmt::print(out, "{}{{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": {}, \"args\": {{\"name\": \"aoc\"}}}}",
+                   sep, pid);
+        sep = ",\n";
+
+        for (size_t tid = 0; tid < buffers_.size(); tid++) {
+            const auto& buf = *buffers_[tid];
+            const auto name = buf.name.empty() ? fmt::format("thread {}", tid) : buf.name;
+            fmt::print(out, "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": {}, \"tid\": {}, "
+                            "\"args\": {{\"name\": {}}}}}", sep, pid, tid, json_quote(name));
+            for (const auto& e : buf.events) {
+                fmt::print(out, "{}{{\"name\": {}, \"ph\": \"X\", \"pid\": {}, \"tid\": {}, "
+                                "\"ts\": {:.3f}, \"dur\": {:.3f}",
+                           sep, json_quote(e.name), pid, tid, us(e.start), us(e.end) - us(e.start));
+                if (e.items >= 0) {
+                    fmt::print(out, ", \"args\": {{\"items\": {}}}", e.items);
+                }
+                fmt::print(out, "}}");
+            }
+        }
+
+        // Simulated timelines get made-up process ids after the real one
+        for (size_t i = 0; i < timelines_.size(); i++) {
+            const auto& tl = timelines_[i];
+            const auto tl_pid = pid + 1 + int(i);
+            fmt::print(out, "{}{{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": {}, "
+                            "\"args\": {{\"name\": {}}}}}", sep, tl_pid, json_quote(tl.name));
+            for (size_t lane = 0; lane < tl.lanes.size(); lane++) {
+                fmt::print(out, "{}{{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": {}, \"tid\": {}, "
+                                "\"args\": {{\"name\": {}}}}}", sep, tl_pid, lane, json_quote(tl.lanes[lane]));
+            }
+            for (const auto& e : tl.events) {
+                fmt::print(out, "{}{{\"name\": {}, \"ph\": \"X\", \"pid\": {}, \"tid\": {}, "
+                                "\"ts\": {:.3f}, \"dur\": {:.3f}}}",
+                           sep, json_quote(e.name), tl_pid, e.lane, e.start.count(), e.length.count());
+            }
+        }
+
+        fmt::print(out, "\n]}}\n");
+        std::fclose(out);
+    }
+
+    time_point start_;
+    std::string path_;
+    bool enabled_ = false;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<thread_buffer>> buffers_;
+    std::set<std::string, std::less<>> names_;
+    std::vector<timeline> timelines_;
+};
+
+class phase {
+public:
+    explicit phase(std::string_view name)
+        : name_(name),
+          before_(state::get().snapshot()),
+          hw_before_(hw_counters::this_thread().read()),
+          prev_hw_sink_(std::exchange(hw_counters::current_sink(), &hw_sink_)),
+          alloc_before_(alloc_stats::begin_phase()),
+          prev_profile_phase_(profiler::get().enter_phase(name)),
+          start_(clock::now())
+    {}
+
+    phase(const phase&) = delete;
+    phase& operator=(const phase&) = delete;
+
+    ~phase()
+    {
+        const auto elapsed = clock::now() - start_;
+        const auto allocs = alloc_stats::end_phase(alloc_before_);
+        auto hw_after = hw_counters::this_thread().read();
+        hw_counters::current_sink() = prev_hw_sink_;
+        // Work done for this phase on pool threads counts for the enclosing
+        // phase too
+        for (size_t i = 0; i < hw_counters::num_events; i++) {
+            const auto pooled = hw_sink_.counts[i].load(std::memory_order_relaxed);
+            hw_after.counts[i] += pooled;
+            if (prev_hw_sink_) {
+                prev_hw_sink_->counts[i].fetch_add(pooled, std::memory_order_relaxed);
+            }
+        }
+        profiler::get().leave_phase(prev_profile_phase_);
+        if (auto& t = tracer::get(); t.enabled()) {
+            t.record(t.intern(name_), start_, start_ + elapsed);
+        }
+        state::get().end_phase(name_, elapsed, hw_before_, hw_after, allocs, before_);
+    }
+
+private:
+    std::string name_;
+    std::vector<std::pair<uint64_t, uint64_t>> before_;
+    hw_counters::values hw_before_;
+    hw_counters::sink hw_sink_;
+    hw_counters::sink* prev_hw_sink_;
+    alloc_stats::sample alloc_before_;
+    uint32_t prev_profile_phase_;
+    clock::time_point start_;
+};
+
+class scoped_timer {
+public:
+    explicit scoped_timer(metric& s)
+        : stat_(s),
+          start_(clock::now())
+    {}
+
+    scoped_timer(const scoped_timer&) = delete;
+    scoped_timer& operator=(const scoped_timer&) = delete;
+
+    ~scoped_timer()
+    {
+        const auto end = clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_);
+        stat_.value.fetch_add(ns.count(), std::memory_order_relaxed);
+        stat_.calls.fetch_add(1, std::memory_order_relaxed);
+        if (auto& t = tracer::get(); t.enabled()) {
+            t.record(stat_.name, start_, end);
+        }
+    }
+
+private:
+    metric& stat_;
+    clock::time_point start_;
+};
+
+inline void count(metric& s, uint64_t n)
+{
+    s.value.fetch_add(n, std::memory_order_relaxed);
+    s.calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
+
+#define AOC_CONCAT_IMPL(a, b) a##b
+#define AOC_CONCAT(a, b) AOC_CONCAT_IMPL(a, b)
+
+#ifdef AOC_INSTRUMENT
+#define AOC_PHASE(name) \
+    ::aoc::instr::phase AOC_CONCAT(aoc_phase_, __LINE__){name}
+#define AOC_SCOPED_TIMER(name) \
+    static auto& AOC_CONCAT(aoc_timer_stat_, __LINE__) = \
+        ::aoc::instr::state::get().get_metric(name, ::aoc::instr::metric::timer); \
+    ::aoc::instr::scoped_timer AOC_CONCAT(aoc_timer_, __LINE__){AOC_CONCAT(aoc_timer_stat_, __LINE__)}
+#define AOC_COUNT(name, n) \
+    do { \
+        static auto& aoc_counter_stat_ = \
+            ::aoc::instr::state::get().get_metric(name, ::aoc::instr::metric::counter); \
+        ::aoc::instr::count(aoc_counter_stat_, n); \
+    } while (false)
+#else
+#define AOC_PHASE(name) ((void) 0)
+#define AOC_SCOPED_TIMER(name) ((void) 0)
+#define AOC_COUNT(name, n) ((void) 0)
+#endif
+
+// Calls func() as the named phase
+template <typename Func>
+decltype(auto) in_phase([[maybe_unused]] std::string_view name, Func&& func)
+{
+    AOC_PHASE(name);
+    return std::forward<Func>(func)();
+}
+
+// Time limits, so that a job on an input which a solver never finishes on
+// (as some bad inputs would be) can't run forever. A deadline_scope sets a
+// deadline for the calling thread, and the days' loops which might not end
+// call check_deadline() as they go, which throws std::runtime_error once it
+// has passed. Thread pool tasks take on the deadline of the thread which
+// handed them out. With no deadline set, as in the days' own main()s and
+// the benchmark, the check is just a thread_local load.
+namespace detail {
+
+inline std::chrono::steady_clock::time_point& thread_deadline()
+{
+    thread_local auto deadline = std::chrono::steady_clock::time_point::max();
+    return deadline;
+}
+
+}
+
+class deadline_scope {
+public:
+    explicit deadline_scope(std::chrono::steady_clock::duration limit)
+        : prev_(std::exchange(detail::thread_deadline(),
+                              std::min(detail::thread_deadline(),
+                                       std::chrono::steady_clock::now() + limit)))
+    {}
+
+    deadline_scope(const deadline_scope&) = delete;
+    deadline_scope& operator=(const deadline_scope&) = delete;
+
+    ~deadline_scope() { detail::thread_deadline() = prev_; }
+
+private:
+    std::chrono::steady_clock::time_point prev_;
+};
+
+inline void check_deadline()
+{
+    const auto deadline = detail::thread_deadline();
+    if (deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() > deadline) {
+        throw std::runtime_error("Time limit exceeded");
+    }
+}
+
+// A work-stealing thread pool. Each worker has its own queue of tasks: it
+// takes work from the back of its own queue and, when that is empty, steals
+// from the front of the others'. parallel_for() splits its range in half
+// recursively, pushing one half and carrying on with the other, so thieves
+// pick up the biggest pieces first.
+//
+// The thread calling parallel_for() joins in until the whole range is done,
+// so a pool of N threads has N - 1 workers. global() is sized from the
+// AOC_THREADS environment variable, or else the number of cores.
+class thread_pool {
+public:
+    explicit thread_pool(size_t num_threads)
+    {
+        const size_t num_workers = num_threads > 1 ? num_threads - 1 : 0;
+        // One queue per worker, plus one for tasks pushed by other threads
+        for (size_t i = 0; i <= num_workers; i++) {
+            queues_.push_back(std::make_unique<task_queue>());
+        }
+        for (size_t i = 0; i < num_workers; i++) {
+            workers_.emplace_back([this, i] { worker_loop(i); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : workers_) {
+            t.join();
+        }
+    }
+
+    static thread_pool& global()
+    {
+        static thread_pool pool([] {
+            size_t n = 0;
+            if (const char* env = std::getenv("AOC_THREADS")) {
+                std::from_chars(env, env + std::strlen(env), n);
+            }
+            return n > 0 ? n : std::max(1u, std::thread::hardware_concurrency());
+        }());
+        return pool;
+    }
+
+    size_t num_threads() const { return workers_.size() + 1; }
+
+    // Calls func(i) for each i in [first, last), in no particular order.
+    // Ranges of grain or fewer indices are not split further; by default,
+    // the range is split into about eight pieces per thread. If any call
+    // throws, one of the exceptions is rethrown once the others are done.
+    template <typename Func>
+    void parallel_for(size_t first, size_t last, Func&& func, size_t grain = 0)
+    {
+        if (first >= last) {
+            return;
+        }
+        const size_t n = last - first;
+        if (grain == 0) {
+            grain = std::max<size_t>(1, n / (8 * num_threads()));
+        }
+        if (workers_.empty() || n <= grain) {
+            for (size_t i = first; i < last; i++) {
+                func(i);
+            }
+            return;
+        }
+
+        job_impl<std::remove_reference_t<Func>> j(func, n, grain);
+        execute(task{&j, first, last});
+
+        // Help out until every index has been dealt with
+        while (j.remaining.load(std::memory_order_acquire) > 0) {
+            task t;
+            if (try_take(t)) {
+                execute(t);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+private:
+    struct job {
+        job(size_t n, size_t grain) : remaining(n), grain(grain) {}
+        virtual ~job() = default;
+        virtual void run(size_t first, size_t last) = 0;
+
+        std::atomic<size_t> remaining;
+        const size_t grain;
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        // Whichever thread runs a task profiles it as the submitter's phase,
+        // and credits the submitter's phase with its hardware counts
+        const uint32_t profile_phase = instr::profiler::get().current_phase();
+        instr::hw_counters::sink* const hw_sink = instr::hw_counters::current_sink();
+        const std::thread::id owner = std::this_thread::get_id();
+        const std::chrono::steady_clock::time_point deadline = detail::thread_deadline();
+    };
+
+    template <typename Func>
+    struct job_impl : job {
+        job_impl(Func& func, size_t n, size_t grain) : job(n, grain), func(func) {}
+
+        void run(size_t first, size_t last) override
+        {
+            for (size_t i = first; i < last; i++) {
+                func(i);
+            }
+        }
+
+        Func& func;
+    };
+
+    struct task {
+        job* j = nullptr;
+        size_t first = 0;
+        size_t last = 0;
+    };
+
+    struct task_queue {
+        std::mutex mutex;
+        std::deque<task> tasks;
+    };
+
+    // Runs t, pushing its right half onto our own queue for as long as it's
+    // worth splitting. The job must not be touched after the final decrement
+    // of its remaining count, as its owner may then return.
+    void execute(task t)
+    {
+        job& j = *t.j;
+        while (t.last - t.first > j.grain) {
+            const size_t mid = t.first + (t.last - t.first) / 2;
+            push(task{t.j, mid, t.last});
+            t.last = mid;
+        }
+
+        auto& prof = instr::profiler::get();
+        const auto prev_phase = prof.adopt_phase(j.profile_phase);
+        auto& hw_sink = instr::hw_counters::current_sink();
+        const auto prev_hw_sink = std::exchange(hw_sink, j.hw_sink);
+        auto& deadline = detail::thread_deadline();
+        const auto prev_deadline = std::exchange(deadline, j.deadline);
+        // The submitting thread's own counters already include its tasks
+        const bool count_hw = instr::enabled && j.hw_sink && j.owner != std::this_thread::get_id();
+        const auto hw_before = count_hw ? instr::hw_counters::this_thread().read()
+                                        : instr::hw_counters::values{};
+        if (!j.failed.load(std::memory_order_relaxed)) {
+            try {
+                if (instr::enabled && instr::tracer::get().enabled()) {
+                    const auto start = instr::clock::now();
+                    j.run(t.first, t.last);
+                    instr::tracer::get().record("task", start, instr::clock::now(),
+                                                int64_t(t.last - t.first));
+                } else {
+                    j.run(t.first, t.last);
+                }
+            } catch (...) {
+                if (!j.failed.exchange(true)) {
+                    j.error = std::current_exception();
+                }
+            }
+        }
+        if (count_hw) {
+            j.hw_sink->add(hw_before, instr::hw_counters::this_thread().read());
+        }
+        hw_sink = prev_hw_sink;
+        deadline = prev_deadline;
+        prof.adopt_phase(prev_phase);
+        j.remaining.fetch_sub(t.last - t.first, std::memory_order_acq_rel);
+    }
+
+    size_t own_queue() const
+    {
+        return current_pool_ == this ? current_index_ : queues_.size() - 1;
+    }
+
+    void push(const task& t)
+    {
+        auto& q = *queues_[own_queue()];
+        {
+            std::lock_guard lock(q.mutex);
+            q.tasks.push_back(t);
+        }
+        pending_.fetch_add(1, std::memory_order_release);
+        {
+            // Taking the lock ensures a worker can't miss the notification
+            // between checking pending_ and going to sleep
+            std::lock_guard lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    bool try_take(task& out)
+    {
+        const size_t own = own_queue();
+        {
+            auto& q = *queues_[own];
+            std::lock_guard lock(q.mutex);
+            if (!q.tasks.empty()) {
+                out = q.tasks.back();
+                q.tasks.pop_back();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        for (size_t k = 1; k < queues_.size(); k++) {
+            auto& q = *queues_[(own + k) % queues_.size()];
+            std::lock_guard lock(q.mutex);
+            if (!q.tasks.empty()) {
+                out = q.tasks.front();
+                q.tasks.pop_front();
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void worker_loop(size_t index)
+    {
+        current_pool_ = this;
+        current_index_ = index;
+        if (instr::enabled && instr::tracer::get().enabled()) {
+            instr::tracer::get().name_thread(fmt::format("pool worker {}", index));
+        }
+
+        while (true) {
+            task t;
+            if (try_take(t)) {
+                execute(t);
+                continue;
+            }
+
+            std::unique_lock lock(sleep_mutex_);
+            wake_.wait(lock, [this] {
+                return stop_ || pending_.load(std::memory_order_acquire) > 0;
+            });
+            if (stop_) {
+                return;
+            }
+        }
+    }
+
+    static inline thread_local const thread_pool* current_pool_ = nullptr;
+    static inline thread_local size_t current_index_ = 0;
+
+    std::vector<std::unique_ptr<task_queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> pending_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+};
+
+// Calls func(i) for each i in [first, last) on the global thread pool
+template <typename Int, typename Func>
+void parallel_for(Int first, Int last, Func&& func)
+{
+    if (first >= last) {
+        return;
+    }
+    thread_pool::global().parallel_for(0, static_cast<size_t>(last - first), [&](size_t i) {
+        func(static_cast<Int>(first + static_cast<Int>(i)));
+    });
+}
+
+namespace detail {
+
+// Splits [0, n) into about four chunks per thread of the global pool, and
+// calls func(chunk, begin, end) for each of them in parallel. Returns the
+// number of chunks.
+template <typename Func>
+size_t parallel_chunks(size_t n, Func&& func)
+{
+    if (n == 0) {
+        return 0;
+    }
+
+    auto& pool = thread_pool::global();
+    const size_t num_chunks = std::min(n, 4 * pool.num_threads());
+    const size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+
+    pool.parallel_for(0, num_chunks, [&](size_t c) {
+        const size_t begin = c * chunk_size;
+        const size_t end = std::min(n, begin + chunk_size);
+        if (begin < end) {
+            func(c, begin, end);
+        }
+    }, 1);
+
+    return num_chunks;
+}
+
+}
+
+// Returns reduce(...reduce(reduce(init, transform(first)), transform(first + 1))...,
+// transform(last - 1)), except that the range is split into chunks which are
+// transformed and reduced in parallel on the global thread pool. The chunk
+// results are then combined in order, so reduce must be associative, but
+// needn't be commutative.
+template <typename Int, typename T, typename Reduce, typename Transform>
+T parallel_reduce(Int first, Int last, T init, Reduce reduce, Transform transform)
+{
+    if (first >= last) {
+        return init;
+    }
+
+    const size_t n = static_cast<size_t>(last - first);
+    std::vector<std::optional<T>> partials(std::min(n, 4 * thread_pool::global().num_threads()));
+    detail::parallel_chunks(n, [&](size_t c, size_t begin, size_t end) {
+        T acc = transform(static_cast<Int>(first + static_cast<Int>(begin)));
+        for (size_t i = begin + 1; i < end; i++) {
+            acc = reduce(std::move(acc), transform(static_cast<Int>(first + static_cast<Int>(i))));
+        }
+        partials[c] = std::move(acc);
+    });
+
+    for (auto& p : partials) {
+        if (p) {
+            init = reduce(std::move(init), std::move(*p));
+        }
+    }
+    return init;
+}
+
+// Execution policies for the algorithm overloads below, named after the
+// std::execution ones. Both split random-access ranges into chunks which
+// run on the global thread pool (ranges too small to be worth it just run
+// on the calling thread). par_unseq also tells the compiler that the
+// iterations of each chunk's loop are independent, so it may vectorise it.
+struct parallel_policy {};
+struct parallel_unsequenced_policy {};
+
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+
+template <typename T>
+inline constexpr bool is_execution_policy_v =
+    std::is_same_v<T, parallel_policy> || std::is_same_v<T, parallel_unsequenced_policy>;
+
+namespace detail {
+
+// Below this many elements, the policy algorithms don't bother with threads
+inline constexpr size_t min_parallel_size = 4096;
+
+// Calls func(i) for each i in [begin, end)
+template <typename Policy, typename Func>
+void chunk_loop(size_t begin, size_t end, Func& func)
+{
+    if constexpr (std::is_same_v<Policy, parallel_unsequenced_policy>) {
+#if defined(__clang__)
+#pragma clang loop vectorize(assume_safety)
+#elif defined(__GNUC__)
+#pragma GCC ivdep
+#endif
+        for (size_t i = begin; i < end; i++) {
+            func(i);
+        }
+    } else {
+        for (size_t i = begin; i < end; i++) {
+            func(i);
+        }
+    }
+}
+
+// Calls func(i) for each i in [0, n), in chunks across the thread pool
+template <typename Policy, typename Func>
+void policy_for(size_t n, Func&& func)
+{
+    if (n < min_parallel_size) {
+        chunk_loop<Policy>(0, n, func);
+        return;
+    }
+    parallel_chunks(n, [&](size_t, size_t begin, size_t end) {
+        chunk_loop<Policy>(begin, end, func);
+    });
+}
+
+// Returns reduce(init, transform(0), ..., transform(n - 1)), reducing each
+// chunk separately and then combining the chunks' results in order
+template <typename Policy, typename T, typename Reduce, typename Transform>
+T policy_reduce(size_t n, T init, Reduce& reduce, Transform&& transform)
+{
+    if (n < min_parallel_size) {
+        for (size_t i = 0; i < n; i++) {
+            init = reduce(std::move(init), transform(i));
+        }
+        return init;
+    }
+
+    std::vector<std::optional<T>> partials(std::min(n, 4 * thread_pool::global().num_threads()));
+    parallel_chunks(n, [&](size_t c, size_t begin, size_t end) {
+        T acc = transform(begin);
+        for (size_t i = begin + 1; i < end; i++) {
+            acc = reduce(std::move(acc), transform(i));
+        }
+        partials[c] = std::move(acc);
+    });
+
+    for (auto& p : partials) {
+        if (p) {
+            init = reduce(std::move(init), std::move(*p));
+        }
+    }
+    return init;
+}
+
+template <typename R>
+constexpr void check_policy_range()
+{
+    static_assert(nano::RandomAccessRange<R> && nano::SizedRange<R>,
+                  "The parallel algorithms need sized, random-access ranges");
+}
+
+}
+
+// As nano::transform(rng, out, op, proj)
+template <typename Policy, typename R, typename Out, typename Op, typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy> && !nano::Range<Out>>>
+Out transform(Policy, R&& rng, Out out, Op op, Proj proj = Proj{})
+{
+    detail::check_policy_range<R>();
+    const auto first = nano::begin(rng);
+    const auto n = static_cast<size_t>(nano::distance(rng));
+    detail::policy_for<Policy>(n, [&](size_t i) {
+        out[i] = std::invoke(op, std::invoke(proj, first[i]));
+    });
+    return out + n;
+}
+
+// As nano::transform(rng1, rng2, out, op)
+template <typename Policy, typename R1, typename R2, typename Out, typename Op,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+Out transform(Policy, R1&& rng1, R2&& rng2, Out out, Op op)
+{
+    detail::check_policy_range<R1>();
+    detail::check_policy_range<R2>();
+    const auto first1 = nano::begin(rng1);
+    const auto first2 = nano::begin(rng2);
+    const auto n = static_cast<size_t>(std::min<ptrdiff_t>(nano::distance(rng1), nano::distance(rng2)));
+    detail::policy_for<Policy>(n, [&](size_t i) {
+        out[i] = std::invoke(op, first1[i], first2[i]);
+    });
+    return out + n;
+}
+
+// As nano::count_if(rng, pred, proj)
+template <typename Policy, typename R, typename Pred, typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+auto count_if(Policy, R&& rng, Pred pred, Proj proj = Proj{})
+{
+    detail::check_policy_range<R>();
+    using diff_t = nano::iter_difference_t<nano::iterator_t<R>>;
+    const auto first = nano::begin(rng);
+    auto plus = std::plus<diff_t>{};
+    return detail::policy_reduce<Policy>(static_cast<size_t>(nano::distance(rng)), diff_t{0}, plus,
+        [&](size_t i) -> diff_t {
+            return std::invoke(pred, std::invoke(proj, first[i])) ? 1 : 0;
+        });
+}
+
+// As nano::count(rng, value, proj)
+template <typename Policy, typename R, typename T, typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+auto count(Policy policy, R&& rng, const T& value, Proj proj = Proj{})
+{
+    return aoc::count_if(policy, std::forward<R>(rng), [&value](const auto& x) {
+        return x == value;
+    }, std::move(proj));
+}
+
+// Returns op(...op(op(init, proj(rng[0])), proj(rng[1]))...), in some
+// grouping of the calls: op must be associative, but needn't be commutative
+template <typename Policy, typename R, typename T, typename Op = std::plus<>,
+          typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+T reduce(Policy, R&& rng, T init, Op op = Op{}, Proj proj = Proj{})
+{
+    detail::check_policy_range<R>();
+    const auto first = nano::begin(rng);
+    auto reduce_op = [&op](T a, auto&& b) -> T {
+        return std::invoke(op, std::move(a), std::forward<decltype(b)>(b));
+    };
+    return detail::policy_reduce<Policy>(static_cast<size_t>(nano::distance(rng)),
+                                         std::move(init), reduce_op,
+                                         [&](size_t i) -> T { return std::invoke(proj, first[i]); });
+}
+
+// As nano::min_element(rng, comp, proj): of several equal smallest elements,
+// returns the first
+template <typename Policy, typename R, typename Comp = nano::less<>, typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+auto min_element(Policy, R&& rng, Comp comp = Comp{}, Proj proj = Proj{})
+{
+    detail::check_policy_range<R>();
+    const auto first = nano::begin(rng);
+    const auto n = static_cast<size_t>(nano::distance(rng));
+    if (n == 0) {
+        return first;
+    }
+
+    // Find the index of the smallest element of each chunk, then of those
+    auto better = [&](size_t a, size_t b) {
+        return std::invoke(comp, std::invoke(proj, first[b]), std::invoke(proj, first[a])) ? b : a;
+    };
+    const size_t idx = detail::policy_reduce<Policy>(n - 1, size_t{0}, better,
+                                                     [](size_t i) { return i + 1; });
+    return first + idx;
+}
+
+// As nano::sort(rng, comp, proj). Chunks are sorted in parallel and then
+// merged in pairs, with the merges at each level also done in parallel.
+template <typename Policy, typename R, typename Comp = nano::less<>, typename Proj = nano::identity,
+          typename = std::enable_if_t<is_execution_policy_v<Policy>>>
+auto sort(Policy, R&& rng, Comp comp = Comp{}, Proj proj = Proj{})
+{
+    detail::check_policy_range<R>();
+    const auto first = nano::begin(rng);
+    const auto n = static_cast<size_t>(nano::distance(rng));
+    if (n < detail::min_parallel_size) {
+        return nano::sort(first, first + n, std::ref(comp), std::ref(proj));
+    }
+
+    const size_t num_chunks = std::min(n, 4 * thread_pool::global().num_threads());
+    const size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+    detail::parallel_chunks(n, [&](size_t, size_t begin, size_t end) {
+        nano::sort(first + begin, first + end, std::ref(comp), std::ref(proj));
+    });
+
+    const auto less = [&](const auto& a, const auto& b) {
+        return std::invoke(comp, std::invoke(proj, a), std::invoke(proj, b));
+    };
+    for (size_t width = chunk_size; width < n; width *= 2) {
+        const size_t num_merges = (n + 2 * width - 1) / (2 * width);
+        thread_pool::global().parallel_for(0, num_merges, [&](size_t m) {
+            const size_t begin = m * 2 * width;
+            const size_t mid = std::min(n, begin + width);
+            const size_t end = std::min(n, begin + 2 * width);
+            std::inplace_merge(first + begin, first + mid, first + end, less);
+        }, 1);
+    }
+
+    return first + n;
+}
+
+// A generator of records which runs on a background thread, so that reading
+// and parsing an input can overlap with solving it. The producer is called
+// once, with a function to pass each record to in turn; the consumer takes
+// them in the same order with a range-for loop over the stream. Records are
+// handed over in batches, and the producer waits when max_batches of them
+// are queued up. If the producer throws, the exception is rethrown to the
+// consumer once the records before it have been taken; if the consumer
+// stops early, the producer is stopped at its next batch. (The same shape as
+// a coroutine generator, but C++17 has no coroutines, so it's a thread.)
+//
+// For a memory-mapped input the producer's thread also takes the page faults,
+// so the reading really does happen in the background.
+template <typename T>
+class record_stream {
+public:
+    template <typename Producer>
+    explicit record_stream(Producer producer, size_t batch_size = 1024, size_t max_batches = 8)
+        : batch_size_(std::max(batch_size, size_t{1})),
+          max_batches_(std::max(max_batches, size_t{1}))
+    {
+        thread_ = std::thread([this, producer = std::move(producer),
+                               phase = instr::profiler::get().current_phase()]() mutable {
+            instr::profiler::get().adopt_phase(phase);
+            produce(producer);
+        });
+    }
+
+    record_stream(const record_stream&) = delete;
+    record_stream& operator=(const record_stream&) = delete;
+
+    ~record_stream()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            cancelled_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T*;
+        using reference = T&;
+
+        iterator() = default;
+
+        T& operator*() const { return stream_->current_[pos_]; }
+        T* operator->() const { return &stream_->current_[pos_]; }
+
+        iterator& operator++()
+        {
+            if (++pos_ == stream_->current_.size()) {
+                pos_ = 0;
+                if (!stream_->next_batch()) {
+                    stream_ = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const iterator& lhs, const iterator& rhs)
+        {
+            return lhs.stream_ == rhs.stream_ && lhs.pos_ == rhs.pos_;
+        }
+
+        friend bool operator!=(const iterator& lhs, const iterator& rhs) { return !(lhs == rhs); }
+
+    private:
+        friend class record_stream;
+        explicit iterator(record_stream* stream) : stream_(stream) {}
+
+        record_stream* stream_ = nullptr;
+        size_t pos_ = 0;
+    };
+
+    // A stream can only be iterated over once
+    iterator begin() { return next_batch() ? iterator{this} : iterator{}; }
+    iterator end() { return iterator{}; }
+
+private:
+    // Thrown through the producer to stop it when the consumer goes away
+    struct cancelled {};
+
+    template <typename Producer>
+    void produce(Producer& producer)
+    {
+        std::vector<T> batch;
+        batch.reserve(batch_size_);
+        try {
+            producer([&](T record) {
+                batch.push_back(std::move(record));
+                if (batch.size() == batch_size_) {
+                    push(std::move(batch));
+                    batch = {};
+                    batch.reserve(batch_size_);
+                }
+            });
+            if (!batch.empty()) {
+                push(std::move(batch));
+            }
+        } catch (const cancelled&) {
+        } catch (...) {
+            std::lock_guard lock(mutex_);
+            if (!batch.empty()) {
+                queue_.push_back(std::move(batch));
+            }
+            error_ = std::current_exception();
+        }
+
+        {
+            std::lock_guard lock(mutex_);
+            done_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void push(std::vector<T>&& batch)
+    {
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return queue_.size() < max_batches_ || cancelled_; });
+            if (cancelled_) {
+                throw cancelled{};
+            }
+            queue_.push_back(std::move(batch));
+        }
+        cv_.notify_all();
+    }
+
+    // Waits for the next batch to arrive, returning false at the end of the
+    // stream
+    bool next_batch()
+    {
+        {
+            std::unique_lock lock(mutex_);
+            cv_.wait(lock, [this] { return !queue_.empty() || done_; });
+            if (queue_.empty()) {
+                if (error_) {
+                    std::rethrow_exception(std::exchange(error_, nullptr));
+                }
+                return false;
+            }
+            current_ = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        cv_.notify_all();
+        return true;
+    }
+
+    const size_t batch_size_;
+    const size_t max_batches_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::vector<T>> queue_;
+    std::vector<T> current_;
+    std::exception_ptr error_;
+    bool done_ = false;
+    bool cancelled_ = false;
+    std::thread thread_;
+};
+
+// Streams parse(line) for each line of the input in the background. The
+// input must outlive the stream.
+template <typename Parse>
+auto stream_lines(std::string_view input, Parse parse)
+{
+    using record_t = std::decay_t<std::invoke_result_t<Parse&, std::string_view>>;
+    return record_stream<record_t>([input, parse](auto&& yield) {
+        for (const auto line : lines(input)) {
+            yield(parse(line));
+        }
+    });
+}
+
+// One file read by read_files(): its contents, or why it couldn't be read
+struct file_read {
+    size_t index = 0; // in the list of paths
+    std::string path;
+    std::string contents;
+    std::string error; // empty on success
+};
+
+namespace detail {
+
+inline std::string describe_read_error(const std::string& path, int err)
+{
+    return fmt::format("Could not read '{}': {}", path, std::strerror(err));
+}
+
+// Reads what's left of fd into out, from the given offset: first to fill
+// out's current size, then on to the end, for files which report a size
+// of zero (as in /proc) or have grown. Pipes, which can't be read at an
+// offset, are read with read(). Returns an errno, or 0.
+inline int read_rest(int fd, std::string& out, size_t offset)
+{
+    while (offset < out.size()) {
+        const auto n = ::pread(fd, out.data() + offset, out.size() - offset, offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return errno;
+        }
+        if (n == 0) {
+            out.resize(offset); // it shrank
+            return 0;
+        }
+        offset += size_t(n);
+    }
+
+    char buf[65536];
+    bool seekable = true;
+    while (true) {
+        auto n = seekable ? ::pread(fd, buf, sizeof(buf), out.size()) : ::read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == ESPIPE && seekable) {
+            seekable = false;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? errno : 0;
+        }
+        out.append(buf, size_t(n));
+    }
+}
+
+// Opens a file for read_files(), sizing its buffer. Returns the fd, or -1
+// with r.error set.
+inline int open_for_read(file_read& r)
+{
+    const int fd = ::open(r.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        r.error = describe_read_error(r.path, errno);
+        return -1;
+    }
+    struct ::stat st{};
+    if (::fstat(fd, &st) != 0) {
+        r.error = describe_read_error(r.path, errno);
+        ::close(fd);
+        return -1;
+    }
+    if (S_ISREG(st.st_mode)) {
+        r.contents.resize(size_t(st.st_size));
+    }
+    return fd;
+}
+
+// The pread() backend: a few threads each reading whole files, handing
+// them back through a queue of at most queue_depth
+template <typename Yield>
+void read_files_pread(const std::vector<std::string>& paths, size_t queue_depth, Yield& yield)
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<file_read> done;
+    size_t next = 0;
+    bool stop = false;
+
+    const auto reader = [&] {
+        std::unique_lock lock(mutex);
+        while (true) {
+            cv.wait(lock, [&] { return stop || next == paths.size() || done.size() < queue_depth; });
+            if (stop || next == paths.size()) {
+                return;
+            }
+            file_read r;
+            r.index = next++;
+            r.path = paths[r.index];
+            lock.unlock();
+
+            if (const int fd = open_for_read(r); fd >= 0) {
+                if (const int err = read_rest(fd, r.contents, 0)) {
+                    r.error = describe_read_error(r.path, err);
+                    r.contents.clear();
+                }
+                ::close(fd);
+            }
+
+            lock.lock();
+            done.push_back(std::move(r));
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min({queue_depth, paths.size(), size_t{8}}); i++) {
+        threads.emplace_back(reader);
+    }
+    const auto join = [&] {
+        {
+            std::lock_guard lock(mutex);
+            stop = true;
+        }
+        cv.notify_all();
+        for (auto& t : threads) {
+            t.join();
+        }
+    };
+
+    try {
+        for (size_t taken = 0; taken < paths.size(); taken++) {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [&] { return !done.empty(); });
+            auto r = std::move(done.front());
+            done.pop_front();
+            lock.unlock();
+            cv.notify_all();
+            yield(std::move(r));
+        }
+    } catch (...) {
+        join();
+        throw;
+    }
+    join();
+}
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+
+// Just enough of io_uring to keep a batch of reads in flight, set up with
+// the raw system calls (so there's no liburing to link against). There's
+// one submitter, so the only synchronisation needed is with the kernel:
+// acquire loads of the indices it writes and release stores of ours.
+class uring {
+public:
+    explicit uring(unsigned entries)
+    {
+        ::io_uring_params p{};
+        fd_ = int(::syscall(__NR_io_uring_setup, entries, &p));
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(::io_uring_cqe);
+        const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+
+        sq_ring_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ring_ = single ? sq_ring_ : map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(::io_uring_sqe);
+        sqes_ = static_cast<::io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+
+        const auto at = [](void* ring, unsigned off) {
+            return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + off);
+        };
+        sq_head_ = at(sq_ring_, p.sq_off.head);
+        sq_tail_ = at(sq_ring_, p.sq_off.tail);
+        sq_mask_ = *at(sq_ring_, p.sq_off.ring_mask);
+        sq_array_ = at(sq_ring_, p.sq_off.array);
+        sq_entries_ = p.sq_entries;
+        cq_head_ = at(cq_ring_, p.cq_off.head);
+        cq_tail_ = at(cq_ring_, p.cq_off.tail);
+        cq_mask_ = *at(cq_ring_, p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<::io_uring_cqe*>(static_cast<char*>(cq_ring_) + p.cq_off.cqes);
+    }
+
+    uring(const uring&) = delete;
+    uring& operator=(const uring&) = delete;
+
+    ~uring()
+    {
+        if (sqes_) ::munmap(sqes_, sqes_size_);
+        if (cq_ring_ && cq_ring_ != sq_ring_) ::munmap(cq_ring_, cq_size_);
+        if (sq_ring_) ::munmap(sq_ring_, sq_size_);
+        if (fd_ >= 0) ::close(fd_);
+    }
+
+    unsigned capacity() const { return sq_entries_; }
+
+    // Queues a read, to be submitted by the next call to wait()
+    void read(int fd, char* buf, size_t len, size_t offset, uint64_t user_data)
+    {
+        const unsigned tail = *sq_tail_;
+        assert(tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) < sq_entries_);
+        const unsigned idx = tail & sq_mask_;
+
+        ::io_uring_sqe& sqe = sqes_[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READ;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(buf);
+        sqe.len = unsigned(std::min(len, size_t{1} << 30));
+        sqe.off = offset;
+        sqe.user_data = user_data;
+
+        sq_array_[idx] = idx;
+        __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+        ++to_submit_;
+    }
+
+    // Submits the queued reads and waits for at least one completion, then
+    // calls func(user_data, result) for each one
+    template <typename Func>
+    void wait(Func&& func)
+    {
+        while (true) {
+            const auto n = ::syscall(__NR_io_uring_enter, fd_, to_submit_, 1,
+                                     IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (n >= 0) {
+                to_submit_ -= std::min<unsigned>(to_submit_, unsigned(n));
+                break;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+            }
+        }
+
+        unsigned head = *cq_head_;
+        const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const auto& cqe = cqes_[head & cq_mask_];
+            func(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    void* map(size_t size, off_t offset)
+    {
+        void* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+        if (ptr == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "io_uring mmap");
+        }
+        return ptr;
+    }
+
+    int fd_ = -1;
+    void* sq_ring_ = nullptr;
+    void* cq_ring_ = nullptr;
+    ::io_uring_sqe* sqes_ = nullptr;
+    size_t sq_size_ = 0;
+    size_t cq_size_ = 0;
+    size_t sqes_size_ = 0;
+    unsigned* sq_head_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned* sq_array_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned sq_entries_ = 0;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    ::io_uring_cqe* cqes_ = nullptr;
+    unsigned to_submit_ = 0;
+};
+
+// The io_uring backend. Files are opened and sized here (which is quick)
+// and their reads queued, keeping up to the ring's capacity in flight;
+// short reads are requeued for the rest. Files of unknown size, and any
+// whose read the kernel refuses (IORING_OP_READ is from Linux 5.6), are
+// read here with read_rest() instead.
+template <typename Yield>
+void read_files_uring(uring& ring, const std::vector<std::string>& paths, Yield& yield)
+{
+    struct pending {
+        file_read r;
+        int fd = -1;
+        size_t offset = 0;
+    };
+    std::vector<pending> files(paths.size());
+    size_t next = 0;
+    size_t in_flight = 0;
+    std::vector<size_t> finished;
+
+    const auto finish = [&](pending& f, int err) {
+        if (err != 0) {
+            f.r.error = describe_read_error(f.r.path, err);
+            f.r.contents.clear();
+        }
+        ::close(f.fd);
+        f.fd = -1;
+    };
+
+    try {
+        while (next < paths.size() || in_flight > 0) {
+            while (next < paths.size() && in_flight < ring.capacity()) {
+                const size_t i = next++;
+                auto& f = files[i];
+                f.r.index = i;
+                f.r.path = paths[i];
+                f.fd = open_for_read(f.r);
+                if (f.fd < 0) {
+                    yield(std::move(f.r));
+                } else if (f.r.contents.empty()) {
+                    finish(f, read_rest(f.fd, f.r.contents, 0));
+                    yield(std::move(f.r));
+                } else {
+                    ring.read(f.fd, f.r.contents.data(), f.r.contents.size(), 0, i);
+                    ++in_flight;
+                }
+            }
+            if (in_flight == 0) {
+                continue;
+            }
+
+            // Hand the finished files over only after the completion queue
+            // has been consumed, since yield() may block for a while
+            finished.clear();
+            ring.wait([&](uint64_t i, int res) {
+                auto& f = files[i];
+                if (res == -EAGAIN || res == -EINTR) {
+                    ring.read(f.fd, f.r.contents.data() + f.offset,
+                              f.r.contents.size() - f.offset, f.offset, i);
+                    return;
+                }
+                if (res == -EINVAL || res == -EOPNOTSUPP) {
+                    finish(f, read_rest(f.fd, f.r.contents, f.offset));
+                } else if (res < 0) {
+                    finish(f, -res);
+                } else if (res == 0) {
+                    f.r.contents.resize(f.offset); // it shrank
+                    finish(f, 0);
+                } else if ((f.offset += size_t(res)) < f.r.contents.size()) {
+                    ring.read(f.fd, f.r.contents.data() + f.offset,
+                              f.r.contents.size() - f.offset, f.offset, i);
+                    return;
+                } else {
+                    finish(f, 0);
+                }
+                --in_flight;
+                finished.push_back(i);
+            });
+            for (const size_t i : finished) {
+                yield(std::move(files[i].r));
+            }
+        }
+    } catch (...) {
+        // The kernel may still be writing into the buffers, so wait for
+        // every read to come back before they're freed
+        while (in_flight > 0) {
+            try {
+                ring.wait([&](uint64_t i, int) {
+                    if (files[i].fd >= 0) {
+                        ::close(std::exchange(files[i].fd, -1));
+                        --in_flight;
+                    }
+                });
+            } catch (...) {
+                break;
+            }
+        }
+        for (auto& f : files) {
+            if (f.fd >= 0) {
+                ::close(f.fd);
+            }
+        }
+        throw;
+    }
+}
+
+#endif
+
+}
+
+// Reads a batch of files in the background, keeping up to queue_depth reads
+// in flight, and hands each one over as soon as it has been read -- so in
+// the order the reads finish, not the order of the paths. Consumers take
+// them with a range-for loop, as for any record_stream, and can solve one
+// input while the next ones are still being read; files that can't be
+// read come through with their error set.
+//
+// On Linux the reads go through io_uring, submitted and reaped on the
+// stream's thread. Where it isn't available (an old kernel, or one with it
+// disabled), or if the AOC_IO environment variable is "pread", a few
+// threads read the files with pread() instead.
+inline record_stream<file_read> read_files(std::vector<std::string> paths, size_t queue_depth = 32)
+{
+    queue_depth = std::max<size_t>(queue_depth, 1);
+
+    return record_stream<file_read>([paths = std::move(paths), queue_depth](auto&& yield) {
+        const char* io = std::getenv("AOC_IO");
+        const bool use_pread = io && std::string_view(io) == "pread";
+
+#if defined(__linux__) && defined(__NR_io_uring_setup)
+        if (!use_pread) {
+            std::optional<detail::uring> ring;
+            try {
+                ring.emplace(unsigned(std::min<size_t>(queue_depth, 4096)));
+            } catch (const std::system_error&) {
+            }
+            if (ring) {
+                detail::read_files_uring(*ring, paths, yield);
+                return;
+            }
+        }
+#else
+        (void) use_pread;
+#endif
+        detail::read_files_pread(paths, queue_depth, yield);
+    }, 1, queue_depth);
+}
+
+// A monotonic arena for std::pmr containers. Memory is handed out from
+// large blocks by bumping a pointer and deallocation does nothing, so
+// everything is freed in one go when the arena is released or destroyed.
+// Like its base class, it isn't thread-safe.
+class arena : public std::pmr::monotonic_buffer_resource {
+public:
+    using monotonic_buffer_resource::monotonic_buffer_resource;
+
+    // Constructs a T in the arena, handing it the arena as its allocator if
+    // it takes one (as the pmr containers do). Its destructor is never run,
+    // so T mustn't own anything outside the arena; the point is that a big
+    // node-based structure can be thrown away without visiting every node.
+    template <typename T, typename... Args>
+    T& make(Args&&... args)
+    {
+        std::pmr::polymorphic_allocator<T> alloc(this);
+        T* ptr = alloc.allocate(1);
+        alloc.construct(ptr, std::forward<Args>(args)...);
+        return *ptr;
+    }
+};
+
+// Backing for the biggest buffers (grids, dec9's circle, dec14's scores),
+// which are scanned at random and so miss the TLB a lot with 4KB pages.
+// Allocations of at least large_page_size bytes are mapped directly and
+// 2MB-aligned, and the AOC_HUGE_PAGES environment variable says how to back
+// them:
+//
+//     transparent   ask for transparent huge pages with madvise(), which
+//                   works when /sys/kernel/mm/transparent_hugepage/enabled
+//                   is "madvise" or "always"
+//     explicit      take them from the reserved pool (vm.nr_hugepages),
+//                   falling back to transparent if the pool is too small
+//
+// Unset (or anything else) leaves every allocation to operator new. On a
+// machine with more than one NUMA node, AOC_NUMA=interleave also spreads
+// each such buffer's pages across the nodes, so that the thread pool's
+// workers share the memory bandwidth evenly rather than all going to the
+// node that first touched the buffer. Memory mapped this way isn't seen by
+// AOC_TRACK_ALLOCS.
+inline constexpr size_t large_page_size = size_t{2} << 20;
+
+namespace detail {
+
+enum class huge_pages { off, transparent, explicit_ };
+
+struct large_page_config {
+    huge_pages mode = huge_pages::off;
+    std::vector<unsigned long> interleave_nodes; // a node mask, if interleaving
+
+    bool enabled() const { return mode != huge_pages::off || !interleave_nodes.empty(); }
+
+    static const large_page_config& get()
+    {
+        static const large_page_config config = [] {
+            large_page_config c;
+            const char* env = std::getenv("AOC_HUGE_PAGES");
+            const std::string_view mode = env ? env : "";
+            if (mode == "transparent") {
+                c.mode = huge_pages::transparent;
+            } else if (mode == "explicit") {
+                c.mode = huge_pages::explicit_;
+            }
+            const char* numa = std::getenv("AOC_NUMA");
+            if (numa && std::string_view(numa) == "interleave") {
+                c.interleave_nodes = online_nodes();
+            }
+            return c;
+        }();
+        return config;
+    }
+
+private:
+    // The online nodes as an mbind() mask, or nothing if there's only one
+    static std::vector<unsigned long> online_nodes()
+    {
+        std::ifstream in("/sys/devices/system/node/online");
+        std::string list;
+        std::getline(in, list);
+
+        constexpr size_t bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask;
+        size_t count = 0;
+        // The list looks like "0-3,8-11"
+        size_t pos = 0;
+        while (pos < list.size()) {
+            const auto end = std::min(list.find(',', pos), list.size());
+            const auto item = std::string_view(list).substr(pos, end - pos);
+            const auto dash = item.find('-');
+            const auto lo = parse_int<size_t>(item.substr(0, dash));
+            const auto hi = dash == std::string_view::npos ? lo : parse_int<size_t>(item.substr(dash + 1));
+            for (size_t n = lo; n <= hi; n++) {
+                mask.resize(std::max(mask.size(), n / bits + 1));
+                mask[n / bits] |= 1ul << (n % bits);
+                ++count;
+            }
+            pos = end + 1;
+        }
+        return count > 1 ? mask : std::vector<unsigned long>{};
+    }
+};
+
+inline size_t round_to_large_pages(size_t bytes)
+{
+    return (bytes + large_page_size - 1) / large_page_size * large_page_size;
+}
+
+inline void* map_large(size_t bytes)
+{
+    const auto& config = large_page_config::get();
+    const size_t len = round_to_large_pages(bytes);
+    void* ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (config.mode == huge_pages::explicit_) {
+        ptr = ::mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+
+    if (ptr == MAP_FAILED) {
+        // Over-allocate so that the start can be moved up to a 2MB boundary,
+        // which the kernel needs to use huge pages for the whole buffer
+        const size_t padded = len + large_page_size;
+        void* raw = ::mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc{};
+        }
+        const auto addr = reinterpret_cast<uintptr_t>(raw);
+        const auto aligned = (addr + large_page_size - 1) & ~(uintptr_t(large_page_size) - 1);
+        if (aligned > addr) {
+            ::munmap(raw, aligned - addr);
+        }
+        if (const auto tail = addr + padded - (aligned + len); tail > 0) {
+            ::munmap(reinterpret_cast<void*>(aligned + len), tail);
+        }
+        ptr = reinterpret_cast<void*>(aligned);
+
+#ifdef MADV_HUGEPAGE
+        if (config.mode != huge_pages::off) {
+            ::madvise(ptr, len, MADV_HUGEPAGE);
+        }
+#endif
+    }
+
+#if defined(__linux__) && defined(SYS_mbind)
+    // Before anything touches the pages, so that none are placed yet
+    if (!config.interleave_nodes.empty()) {
+        const auto& nodes = config.interleave_nodes;
+        ::syscall(SYS_mbind, ptr, len, MPOL_INTERLEAVE, nodes.data(),
+                  nodes.size() * 8 * sizeof(unsigned long), 0);
+    }
+#endif
+
+    return ptr;
+}
+
+}
+
+// A std::allocator replacement which maps large allocations as described
+// above, and leaves the rest to operator new
+template <typename T>
+struct large_page_allocator {
+    using value_type = T;
+
+    large_page_allocator() = default;
+
+    template <typename U>
+    large_page_allocator(const large_page_allocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        const size_t bytes = n * sizeof(T);
+        if (bytes >= large_page_size && detail::large_page_config::get().enabled()) {
+            return static_cast<T*>(detail::map_large(bytes));
+        }
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, size_t n)
+    {
+        const size_t bytes = n * sizeof(T);
+        if (bytes >= large_page_size && detail::large_page_config::get().enabled()) {
+            ::munmap(ptr, detail::round_to_large_pages(bytes));
+        } else {
+            std::allocator<T>{}.deallocate(ptr, n);
+        }
+    }
+
+    template <typename U>
+    friend bool operator==(const large_page_allocator&, const large_page_allocator<U>&) { return true; }
+
+    template <typename U>
+    friend bool operator!=(const large_page_allocator&, const large_page_allocator<U>&) { return false; }
+};
+
+template <typename T>
+using large_vector = std::vector<T, large_page_allocator<T>>;
+
+// A rectangle of grid cells, [x, x + width) by [y, y + height)
+struct grid_rect {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Ways of laying out a grid's cells in memory. Each maps a cell to its index
+// in the grid's storage, and says how many cells need allocating (which may
+// be more than width * height, as the other layouts pad the grid out).
+// block_size is the side of the square blocks which are stored contiguously,
+// or zero if there are none; for_each_in() visits a block at a time.
+namespace grid_layout {
+
+// The usual row-by-row layout
+struct row_major {
+    static constexpr int block_size = 0;
+
+    static size_t storage_size(int width, int height)
+    {
+        return size_t(width) * height;
+    }
+
+    static size_t index(int x, int y, int width)
+    {
+        return size_t(y) * width + x;
+    }
+};
+
+// Row-major tiles of Tile by Tile cells, each stored row-major, so that
+// cells which are close in both directions are close in memory
+template <int Tile = 16>
+struct tiled {
+    static_assert(Tile > 0 && (Tile & (Tile - 1)) == 0, "Tile size must be a power of two");
+
+    static constexpr int block_size = Tile;
+
+    static size_t storage_size(int width, int height)
+    {
+        return size_t(tiles(width)) * tiles(height) * Tile * Tile;
+    }
+
+    static size_t index(int x, int y, int width)
+    {
+        const size_t tile = size_t(y / Tile) * tiles(width) + x / Tile;
+        return (tile * Tile + y % Tile) * Tile + x % Tile;
+    }
+
+private:
+    static int tiles(int n) { return (n + Tile - 1) / Tile; }
+};
+
+// Morton (Z-)order, interleaving the bits of the x and y coordinates.
+// Grids which aren't square with a power-of-two side are padded out,
+// which can be very wasteful for long, thin grids.
+struct morton {
+    static constexpr int block_size = 8;
+
+    static size_t storage_size(int width, int height)
+    {
+        return width > 0 && height > 0 ? index(width - 1, height - 1, width) + 1 : 0;
+    }
+
+    static size_t index(int x, int y, int /*width*/)
+    {
+        return spread(x) | (spread(y) << 1);
+    }
+
+private:
+    // Moves bit n of i to bit 2n
+    static uint64_t spread(uint32_t i)
+    {
+        uint64_t v = i;
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F;
+        v = (v | (v << 2)) & 0x3333333333333333;
+        v = (v | (v << 1)) & 0x5555555555555555;
+        return v;
+    }
+};
+
+}
+
+// The layout grids use unless told otherwise. Build with, for example,
+// -DAOC_GRID_LAYOUT='tiled<32>' to compare the locality of the layouts
+// on the same solvers.
+#ifndef AOC_GRID_LAYOUT
+#define AOC_GRID_LAYOUT row_major
+#endif
+
+// A width by height grid of cells, indexed by (x, y) from (0, 0) at the
+// top left. The iteration functions call func(x, y, cell) for each cell
+// they visit.
+template <typename T, typename Layout = grid_layout::AOC_GRID_LAYOUT>
+class grid {
+public:
+    using value_type = T;
+    using layout_type = Layout;
+
+    grid() = default;
+
+    grid(int width, int height, const T& value = T{})
+        : width_(width),
+          height_(height),
+          cells_(Layout::storage_size(width, height), value)
+    {
+        assert(width >= 0 && height >= 0);
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    grid_rect bounds() const { return {0, 0, width_, height_}; }
+
+    bool contains(int x, int y) const
+    {
+        return x >= 0 && x < width_ && y >= 0 && y < height_;
+    }
+
+    T& operator()(int x, int y)
+    {
+        assert(contains(x, y));
+        return cells_[Layout::index(x, y, width_)];
+    }
+
+    const T& operator()(int x, int y) const
+    {
+        assert(contains(x, y));
+        return cells_[Layout::index(x, y, width_)];
+    }
+
+    // Visits each cell of r which is inside the grid. For tiled layouts the
+    // cells are visited a tile at a time, so only row_major grids are
+    // guaranteed to be visited row by row.
+    template <typename Func>
+    void for_each_in(const grid_rect& r, Func&& func) { for_each_in_impl(*this, r, func); }
+
+    template <typename Func>
+    void for_each_in(const grid_rect& r, Func&& func) const { for_each_in_impl(*this, r, func); }
+
+    template <typename Func>
+    void for_each(Func&& func) { for_each_in_impl(*this, bounds(), func); }
+
+    template <typename Func>
+    void for_each(Func&& func) const { for_each_in_impl(*this, bounds(), func); }
+
+    // Visits the (up to) eight cells surrounding (x, y)
+    template <typename Func>
+    void for_each_neighbour(int x, int y, Func&& func) { neighbours_impl<true>(*this, x, y, func); }
+
+    template <typename Func>
+    void for_each_neighbour(int x, int y, Func&& func) const { neighbours_impl<true>(*this, x, y, func); }
+
+    // Visits the (up to) four cells above, below, left and right of (x, y)
+    template <typename Func>
+    void for_each_adjacent(int x, int y, Func&& func) { neighbours_impl<false>(*this, x, y, func); }
+
+    template <typename Func>
+    void for_each_adjacent(int x, int y, Func&& func) const { neighbours_impl<false>(*this, x, y, func); }
+
+private:
+    template <typename Self, typename Func>
+    static void for_each_in_impl(Self& self, const grid_rect& r, Func& func)
+    {
+        const int x0 = std::max(r.x, 0);
+        const int y0 = std::max(r.y, 0);
+        const int x1 = std::min(r.x + r.width, self.width_);
+        const int y1 = std::min(r.y + r.height, self.height_);
+
+        constexpr int b = Layout::block_size;
+        if constexpr (b == 0) {
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    func(x, y, self(x, y));
+                }
+            }
+        } else {
+            for (int by = y0 / b * b; by < y1; by += b) {
+                for (int bx = x0 / b * b; bx < x1; bx += b) {
+                    for (int y = std::max(by, y0); y < std::min(by + b, y1); y++) {
+                        for (int x = std::max(bx, x0); x < std::min(bx + b, x1); x++) {
+                            func(x, y, self(x, y));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    template <bool Diagonals, typename Self, typename Func>
+    static void neighbours_impl(Self& self, int x, int y, Func& func)
+    {
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                if ((dx == 0 && dy == 0) || (!Diagonals && dx != 0 && dy != 0)) {
+                    continue;
+                }
+                if (self.contains(x + dx, y + dy)) {
+                    func(x + dx, y + dy, self(x + dx, y + dy));
+                }
+            }
+        }
+    }
+
+    int width_ = 0;
+    int height_ = 0;
+    large_vector<T> cells_;
+};
+
+// Binary serialisation of parsed inputs, for parse_cache below. Arithmetic
+// and enum values are stored as their bytes, in the machine's own byte
+// order, and std::vector, std::array and std::pair element by element (with
+// a vector's length first). Any other type opts in by providing
+//
+//     template <typename Archive>
+//     void serialise(Archive& ar, T& value) { ar(value.a, value.b); }
+//
+// in its own namespace, which is used both for writing and for reading.
+class binary_writer;
+
+namespace detail {
+
+template <typename T>
+struct is_vector : std::false_type {};
+
+template <typename T, typename A>
+struct is_vector<std::vector<T, A>> : std::true_type {};
+
+template <typename T>
+struct is_std_array : std::false_type {};
+
+template <typename T, size_t N>
+struct is_std_array<std::array<T, N>> : std::true_type {};
+
+template <typename T>
+struct is_pair : std::false_type {};
+
+template <typename T, typename U>
+struct is_pair<std::pair<T, U>> : std::true_type {};
+
+template <typename T>
+constexpr bool is_bytewise_v = (std::is_arithmetic_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>;
+
+template <typename T, typename = void>
+struct has_serialise : std::false_type {};
+
+template <typename T>
+struct has_serialise<T, std::void_t<decltype(serialise(std::declval<binary_writer&>(), std::declval<T&>()))>>
+    : std::true_type {};
+
+}
+
+template <typename T>
+constexpr bool is_serialisable()
+{
+    if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+        return true;
+    } else if constexpr (detail::is_vector<T>::value || detail::is_std_array<T>::value) {
+        return is_serialisable<typename T::value_type>();
+    } else if constexpr (detail::is_pair<T>::value) {
+        return is_serialisable<typename T::first_type>() && is_serialisable<typename T::second_type>();
+    } else {
+        return detail::has_serialise<T>::value;
+    }
+}
+
+class binary_writer {
+public:
+    template <typename... Ts>
+    void operator()(const Ts&... values) { (write(values), ...); }
+
+    std::string take() { return std::move(out_); }
+
+private:
+    template <typename T>
+    void write(const T& value)
+    {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        } else if constexpr (detail::is_vector<T>::value) {
+            write(uint64_t(value.size()));
+            if constexpr (detail::is_bytewise_v<typename T::value_type>) {
+                out_.append(reinterpret_cast<const char*>(value.data()),
+                            value.size() * sizeof(typename T::value_type));
+            } else {
+                for (const auto& v : value) {
+                    write(v);
+                }
+            }
+        } else if constexpr (detail::is_std_array<T>::value) {
+            for (const auto& v : value) {
+                write(v);
+            }
+        } else if constexpr (detail::is_pair<T>::value) {
+            write(value.first);
+            write(value.second);
+        } else {
+            serialise(*this, const_cast<T&>(value));
+        }
+    }
+
+    std::string out_;
+};
+
+// Reads back what a binary_writer wrote. Reading past the end of the bytes
+// leaves the rest zeroed and makes ok() false, rather than throwing.
+class binary_reader {
+public:
+    explicit binary_reader(std::string_view bytes) : in_(bytes) {}
+
+    template <typename... Ts>
+    void operator()(Ts&... values) { (read(values), ...); }
+
+    bool ok() const { return ok_; }
+    bool at_end() const { return in_.empty(); }
+
+private:
+    void read_bytes(void* dest, size_t n)
+    {
+        if (n > in_.size()) {
+            ok_ = false;
+            in_ = {};
+            std::memset(dest, 0, n);
+            return;
+        }
+        std::memcpy(dest, in_.data(), n);
+        in_.remove_prefix(n);
+    }
+
+    template <typename T>
+    void read(T& value)
+    {
+        if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+            read_bytes(&value, sizeof(T));
+        } else if constexpr (detail::is_vector<T>::value) {
+            uint64_t n = 0;
+            read(n);
+            // Every element takes at least a byte, so a bigger length is bad
+            if (n > in_.size()) {
+                ok_ = false;
+                in_ = {};
+                return;
+            }
+            value.resize(n);
+            if constexpr (detail::is_bytewise_v<typename T::value_type>) {
+                read_bytes(value.data(), n * sizeof(typename T::value_type));
+            } else {
+                for (auto& v : value) {
+                    read(v);
+                }
+            }
+        } else if constexpr (detail::is_std_array<T>::value) {
+            for (auto& v : value) {
+                read(v);
+            }
+        } else if constexpr (detail::is_pair<T>::value) {
+            read(value.first);
+            read(value.second);
+        } else {
+            serialise(*this, value);
+        }
+    }
+
+    std::string_view in_;
+    bool ok_ = true;
+};
+
+// Type-erased access to a day's solver, so that tools such as the benchmark
+// can drive every day through the same interface. Each day registers its
+// parse, part one and part two functions at static initialisation time;
+// days whose parts live in separate files (dec2, dec8) register one entry
+// per file, leaving the other part empty. The version is part of the key
+// for cached results and parsed inputs (see result_cache and parse_cache
+// below), so it must be bumped whenever a change to a solver could change
+// its answers, or a change to its parser its parsed input.
+//
+// If the parsed input can be serialised (see binary_writer above),
+// save_input and load_input convert it to and from bytes; otherwise they
+// are empty. load_input returns an empty std::any if the bytes are bad.
+struct day_entry {
+    int day = 0;
+    std::string name;
+    int version = 1;
+    std::function<std::any(std::string_view)> parse;
+    std::function<std::string(const std::any&)> part_one;
+    std::function<std::string(const std::any&)> part_two;
+    std::function<std::string(const std::any&)> save_input;
+    std::function<std::any(std::string_view)> load_input;
+};
+
+inline std::vector<day_entry>& registry()
+{
+    static std::vector<day_entry> days;
+    return days;
+}
+
+// Days with a fast path also register their original, straightforward
+// solver here under the same name, so that the benchmark's --verify mode
+// can check one against the other on the same input
+inline std::vector<day_entry>& reference_registry()
+{
+    static std::vector<day_entry> days;
+    return days;
+}
+
+template <typename T>
+std::string to_result_string(const T& result)
+{
+    if constexpr (std::is_same_v<T, std::string>) {
+        return result;
+    } else {
+        return fmt::format("{}", result);
+    }
+}
+
+template <typename T>
+std::string to_result_string(const std::optional<T>& result)
+{
+    return result ? to_result_string(*result) : std::string("<none>");
+}
+
+namespace detail {
+
+template <typename Input, typename Part>
+std::function<std::string(const std::any&)> erase_part(Part part)
+{
+    if constexpr (std::is_null_pointer_v<Part>) {
+        return {};
+    } else {
+        return [part](const std::any& input) {
+            return to_result_string(part(std::any_cast<const Input&>(input)));
+        };
+    }
+}
+
+}
+
+namespace detail {
+
+template <typename Parse, typename PartOne, typename PartTwo>
+day_entry make_entry(int day, std::string name, Parse parse, PartOne part_one, PartTwo part_two,
+                     int version)
+{
+    using input_t = std::decay_t<std::invoke_result_t<Parse, std::string_view>>;
+
+    day_entry entry;
+    entry.day = day;
+    entry.name = std::move(name);
+    entry.version = version;
+    entry.parse = [parse](std::string_view str) -> std::any { return parse(str); };
+    entry.part_one = detail::erase_part<input_t>(std::move(part_one));
+    entry.part_two = detail::erase_part<input_t>(std::move(part_two));
+
+    if constexpr (is_serialisable<input_t>() && std::is_default_constructible_v<input_t>) {
+        entry.save_input = [](const std::any& input) {
+            binary_writer w;
+            w(std::any_cast<const input_t&>(input));
+            return w.take();
+        };
+        entry.load_input = [](std::string_view bytes) -> std::any {
+            input_t input{};
+            binary_reader r(bytes);
+            r(input);
+            if (!r.ok() || !r.at_end()) {
+                return {};
+            }
+            return input;
+        };
+    }
+
+    return entry;
+}
+
+}
+
+template <typename Parse, typename PartOne, typename PartTwo>
+bool register_day(int day, std::string name, Parse parse, PartOne part_one, PartTwo part_two,
+                  int version = 1)
+{
+    auto entry = detail::make_entry(day, name, std::move(parse), std::move(part_one),
+                                    std::move(part_two), version);
+
+    if constexpr (instr::enabled) {
+        // Make each stage a phase of its own when instrumenting
+        const auto wrap = [&name](auto& func, const char* stage) {
+            if (func) {
+                func = [func, phase_name = name + '/' + stage](const auto& arg) {
+                    return in_phase(phase_name, [&] { return func(arg); });
+                };
+            }
+        };
+        wrap(entry.parse, "parse");
+        wrap(entry.part_one, "part_one");
+        wrap(entry.part_two, "part_two");
+    }
+
+    registry().push_back(std::move(entry));
+
+    return true;
+}
+
+template <typename Parse, typename PartOne, typename PartTwo>
+bool register_reference(int day, std::string name, Parse parse, PartOne part_one, PartTwo part_two)
+{
+    reference_registry().push_back(detail::make_entry(day, std::move(name), std::move(parse),
+                                                      std::move(part_one), std::move(part_two), 1));
+    return true;
+}
+
+// The registered entries for a day: one, or two for the days whose parts
+// live in separate files
+inline std::vector<const day_entry*> find_day(int day)
+{
+    std::vector<const day_entry*> entries;
+    for (const auto& e : registry()) {
+        if (e.day == day) {
+            entries.push_back(&e);
+        }
+    }
+    return entries;
+}
+
+// A solver bundles a day's stages as static member functions:
+//
+//     struct solver {
+//         static input parse(std::string_view text);
+//         static R1 part_one(const input&);
+//         static R2 part_two(const input&);
+//     };
+//
+// where either part may be left out. solver_traits gives the input and
+// result types (void for a missing part), solve() runs every stage with its
+// result still typed, and register_solver() registers it like register_day().
+namespace detail {
+
+template <typename S, typename = void>
+struct has_parse : std::false_type {};
+
+template <typename S>
+struct has_parse<S, std::void_t<decltype(S::parse(std::string_view{}))>> : std::true_type {};
+
+template <typename S, typename Input, typename = void>
+struct has_part_one : std::false_type {};
+
+template <typename S, typename Input>
+struct has_part_one<S, Input, std::void_t<decltype(S::part_one(std::declval<const Input&>()))>>
+    : std::true_type {};
+
+template <typename S, typename Input, typename = void>
+struct has_part_two : std::false_type {};
+
+template <typename S, typename Input>
+struct has_part_two<S, Input, std::void_t<decltype(S::part_two(std::declval<const Input&>()))>>
+    : std::true_type {};
+
+template <bool Has, template <typename...> typename Result, typename... Args>
+struct part_result { using type = void; };
+
+template <template <typename...> typename Result, typename... Args>
+struct part_result<true, Result, Args...> { using type = typename Result<Args...>::type; };
+
+template <typename S, typename Input>
+struct part_one_result { using type = decltype(S::part_one(std::declval<const Input&>())); };
+
+template <typename S, typename Input>
+struct part_two_result { using type = decltype(S::part_two(std::declval<const Input&>())); };
+
+}
+
+template <typename S, typename = void>
+struct solver_traits {
+    static constexpr bool is_solver = false;
+};
+
+template <typename S>
+struct solver_traits<S, std::enable_if_t<detail::has_parse<S>::value>> {
+    using input_type = std::decay_t<decltype(S::parse(std::string_view{}))>;
+
+    static constexpr bool has_part_one = detail::has_part_one<S, input_type>::value;
+    static constexpr bool has_part_two = detail::has_part_two<S, input_type>::value;
+    static constexpr bool is_solver = has_part_one || has_part_two;
+
+    using part_one_type = typename detail::part_result<has_part_one, detail::part_one_result,
+                                                       S, input_type>::type;
+    using part_two_type = typename detail::part_result<has_part_two, detail::part_two_result,
+                                                       S, input_type>::type;
+};
+
+template <typename S>
+inline constexpr bool is_solver_v = solver_traits<S>::is_solver;
+
+// The typed results of running a solver, with a missing part left empty
+template <typename S>
+struct solution {
+    using traits = solver_traits<S>;
+    template <typename T>
+    using slot = std::conditional_t<std::is_void_v<T>, std::monostate, std::optional<T>>;
+
+    typename traits::input_type input;
+    slot<typename traits::part_one_type> part_one;
+    slot<typename traits::part_two_type> part_two;
+};
+
+template <typename S>
+solution<S> solve(std::string_view text)
+{
+    static_assert(is_solver_v<S>, "S needs a static parse() and part_one() or part_two()");
+    using traits = solver_traits<S>;
+
+    solution<S> out{in_phase("parse", [&] { return S::parse(text); }), {}, {}};
+    if constexpr (traits::has_part_one) {
+        out.part_one = in_phase("part_one", [&] { return S::part_one(out.input); });
+    }
+    if constexpr (traits::has_part_two) {
+        out.part_two = in_phase("part_two", [&] { return S::part_two(out.input); });
+    }
+    return out;
+}
+
+template <typename S>
+bool register_solver(int day, std::string name, int version = 1)
+{
+    static_assert(is_solver_v<S>, "S needs a static parse() and part_one() or part_two()");
+    using traits = solver_traits<S>;
+    using input_t = typename traits::input_type;
+
+    const auto part_one = [] {
+        if constexpr (traits::has_part_one) {
+            return [](const input_t& in) { return S::part_one(in); };
+        } else {
+            return nullptr;
+        }
+    };
+    const auto part_two = [] {
+        if constexpr (traits::has_part_two) {
+            return [](const input_t& in) { return S::part_two(in); };
+        } else {
+            return nullptr;
+        }
+    };
+    return register_day(day, std::move(name), [](std::string_view text) { return S::parse(text); },
+                        part_one(), part_two(), version);
+}
+
+// The main() for every day: it reads the input file named on the command
+// line (or stdin, given "-") and passes its text to func(), which prints the
+// answers as "Part one: ..." and "Part two: ...". A missing argument gives a
+// usage message and exit status 1, and any exception thrown while reading
+// or solving is printed to stderr with exit status 2. Days which stream
+// their input call this with their own func(); the rest use the overload
+// taking a day, further down.
+template <typename Func,
+          typename = std::enable_if_t<std::is_invocable_v<Func&, std::string_view>>>
+int run_main(int argc, char** argv, Func&& func)
+{
+    if (argc < 2) {
+        fmt::print(stderr, "Usage: {} <input file>\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        std::string from_stdin;
+        std::optional<mapped_file> file;
+        std::string_view input;
+        if (std::string_view(argv[1]) == "-") {
+            from_stdin.assign(std::istreambuf_iterator<char>(std::cin), {});
+            input = from_stdin;
+        } else {
+            file.emplace(argv[1]);
+            input = file->view();
+        }
+        func(input);
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "{}\n", e.what());
+        return 2;
+    }
+
+    return 0;
+}
+
+// A 64-bit hash of a block of bytes, taking eight at a time. It's quick and
+// spreads its bits well, but it isn't cryptographic.
+inline uint64_t hash_bytes(std::string_view bytes)
+{
+    constexpr uint64_t mul = 0x9e3779b97f4a7c15;
+    const auto rotl = [](uint64_t x, int r) { return (x << r) | (x >> (64 - r)); };
+
+    uint64_t h = 0xcbf29ce484222325 ^ (bytes.size() * mul);
+    size_t i = 0;
+    for (; i + 8 <= bytes.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i, 8);
+        h = rotl((h ^ word) * mul, 31);
+    }
+    for (; i < bytes.size(); i++) {
+        h = rotl((h ^ static_cast<unsigned char>(bytes[i])) * mul, 31);
+    }
+
+    // Final avalanche, as in MurmurHash3
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53;
+    h ^= h >> 33;
+    return h;
+}
+
+// An on-disk cache of solver results. Each entry is a file in the cache
+// directory, named after the registry entry, its version, and the size and
+// hash of the input; the file also records those, which are checked again
+// on reading.
+//
+// Entries are written to a temporary file which is then rename()d into
+// place, so any number of threads or processes can share a cache: readers
+// see either a complete entry or none, and if two writers race, one of
+// their (identical) entries wins.
+namespace detail {
+
+// Writes the chunks to a temporary file in dir and renames it to path, so
+// that concurrent readers see either the whole file or none of it
+inline bool write_file_atomically(const std::string& dir, const std::string& path,
+                                  std::initializer_list<std::string_view> chunks)
+{
+    static std::atomic<unsigned> counter{0};
+    const auto tmp = fmt::format("{}/.tmp-{}-{}", dir, ::getpid(), counter++);
+
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = true;
+    for (const auto chunk : chunks) {
+        if (!chunk.empty()) {
+            ok = ok && std::fwrite(chunk.data(), chunk.size(), 1, f) == 1;
+        }
+    }
+    ok = std::fclose(f) == 0 && ok;
+
+    if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+class result_cache {
+public:
+    struct results {
+        std::optional<std::string> part_one;
+        std::optional<std::string> part_two;
+    };
+
+    explicit result_cache(std::string dir)
+        : dir_(std::move(dir))
+    {
+        if (::mkdir(dir_.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error(fmt::format("Could not create cache directory '{}'", dir_));
+        }
+    }
+
+    // Identifies the results of one registry entry for one input
+    class key {
+    public:
+        key(const day_entry& entry, std::string_view input)
+            : name_(entry.name),
+              version_(entry.version),
+              size_(input.size()),
+              hash_(hash_bytes(input))
+        {}
+
+    private:
+        friend class result_cache;
+        friend class parse_cache;
+
+        std::string file_name() const
+        {
+            std::string name = name_;
+            std::replace(name.begin(), name.end(), '/', '_');
+            return fmt::format("{}-v{}-{:016x}-{}", name, version_, hash_, size_);
+        }
+
+        std::string name_;
+        int version_;
+        size_t size_;
+        uint64_t hash_;
+    };
+
+    std::optional<results> find(const key& k) const
+    {
+        std::FILE* f = std::fopen(path(k).c_str(), "rb");
+        if (!f) {
+            return std::nullopt;
+        }
+        std::string contents;
+        char buf[4096];
+        size_t n = 0;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+            contents.append(buf, n);
+        }
+        std::fclose(f);
+
+        // A header line, and then the results one after the other. A
+        // length of -1 means that there is no such part.
+        const auto eol = contents.find('\n');
+        if (eol == std::string::npos) {
+            return std::nullopt;
+        }
+        std::string_view name;
+        int version = 0;
+        size_t size = 0;
+        int64_t len_one = 0;
+        int64_t len_two = 0;
+        constexpr pattern header{"aoc-result {} {} {} {} {}"};
+        if (!header.scan(std::string_view(contents).substr(0, eol), name, version, size, len_one, len_two) ||
+            name != k.name_ || version != k.version_ || size != k.size_ ||
+            std::max<int64_t>(len_one, 0) + std::max<int64_t>(len_two, 0) != int64_t(contents.size() - eol - 1)) {
+            return std::nullopt;
+        }
+
+        results r;
+        size_t pos = eol + 1;
+        if (len_one >= 0) {
+            r.part_one = contents.substr(pos, len_one);
+            pos += len_one;
+        }
+        if (len_two >= 0) {
+            r.part_two = contents.substr(pos, len_two);
+        }
+        return r;
+    }
+
+    // Failing to write an entry isn't an error: the results just won't be
+    // cached. Returns whether the entry was written.
+    bool store(const key& k, const results& r) const
+    {
+        const auto len = [](const auto& part) { return part ? int64_t(part->size()) : int64_t{-1}; };
+        const auto header = fmt::format("aoc-result {} {} {} {} {}\n", k.name_, k.version_, k.size_,
+                                        len(r.part_one), len(r.part_two));
+        return detail::write_file_atomically(dir_, path(k), {header, r.part_one.value_or(""),
+                                                              r.part_two.value_or("")});
+    }
+
+private:
+    std::string path(const key& k) const { return dir_ + '/' + k.file_name(); }
+
+    std::string dir_;
+};
+
+// Parsed inputs kept on disk in binary form, for the registry entries that
+// can serialise theirs, so that repeated runs over the same big input can
+// map the file and load it rather than parse the text again. Entries are
+// keyed as for result_cache (and can share its directory), with a header
+// line giving the name, version, input size and payload length.
+//
+// Opening and mapping the entry costs a tenth of a millisecond or so, which
+// is more than parsing a small input takes, so inputs smaller than
+// min_input_size are never cached: find() and store() ignore them.
+class parse_cache {
+public:
+    using key = result_cache::key;
+
+    static constexpr size_t min_input_size = 32 * 1024;
+
+    static bool worth_caching(std::string_view input)
+    {
+        return input.size() >= min_input_size;
+    }
+
+    explicit parse_cache(std::string dir)
+        : dir_(std::move(dir))
+    {
+        if (::mkdir(dir_.c_str(), 0777) != 0 && errno != EEXIST) {
+            throw std::runtime_error(fmt::format("Could not create cache directory '{}'", dir_));
+        }
+    }
+
+    // Returns the cached parsed input, or nullopt if there is none or it
+    // doesn't check out
+    std::optional<std::any> find(const day_entry& entry, const key& k) const
+    {
+        if (!entry.load_input || k.size_ < min_input_size) {
+            return std::nullopt;
+        }
+        // The entry may be missing, or be replaced or removed by another
+        // run at any moment, so just try to open it
+        std::optional<mapped_file> file;
+        try {
+            file.emplace(path(k).c_str());
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+        const auto contents = file->view();
+
+        const auto eol = contents.find('\n');
+        if (eol == std::string_view::npos) {
+            return std::nullopt;
+        }
+        std::string_view name;
+        int version = 0;
+        size_t size = 0;
+        size_t len = 0;
+        constexpr pattern header{"aoc-parsed {} {} {} {}"};
+        if (!header.scan(contents.substr(0, eol), name, version, size, len) ||
+            name != k.name_ || version != k.version_ || size != k.size_ ||
+            len != contents.size() - eol - 1) {
+            return std::nullopt;
+        }
+
+        auto input = entry.load_input(contents.substr(eol + 1));
+        if (!input.has_value()) {
+            return std::nullopt;
+        }
+        return input;
+    }
+
+    // As for result_cache::store(), failing to write isn't an error
+    bool store(const day_entry& entry, const key& k, const std::any& input) const
+    {
+        if (!entry.save_input || k.size_ < min_input_size) {
+            return false;
+        }
+        const auto bytes = entry.save_input(input);
+        const auto header = fmt::format("aoc-parsed {} {} {} {}\n", k.name_, k.version_, k.size_,
+                                        bytes.size());
+        return detail::write_file_atomically(dir_, path(k), {header, bytes});
+    }
+
+private:
+    std::string path(const key& k) const { return dir_ + '/' + k.file_name() + ".parsed"; }
+
+    std::string dir_;
+};
+
+// Runs every registered entry for the day and prints each part's result.
+// When instrumenting, each stage is a phase, as it is in the benchmark.
+// With AOC_CACHE_DIR set, results are looked up in and added to a
+// result_cache in that directory, as with the server's --cache, so a day
+// run again on the same input just prints the cached answers.
+inline int run_main(int argc, char** argv, int day)
+{
+    const auto entries = find_day(day);
+    if (entries.empty()) {
+        fmt::print(stderr, "Day {} is not registered\n", day);
+        return 1;
+    }
+
+    return run_main(argc, argv, [&](std::string_view input) {
+        std::optional<result_cache> cache;
+        if (const char* dir = std::getenv("AOC_CACHE_DIR"); dir && *dir) {
+            cache.emplace(dir);
+        }
+
+        for (const auto* entry : entries) {
+            std::optional<result_cache::key> key;
+            std::optional<result_cache::results> results;
+            if (cache) {
+                key.emplace(*entry, input);
+                results = cache->find(*key);
+            }
+            if (!results) {
+                const auto parsed = entry->parse(input);
+                results.emplace();
+                if (entry->part_one) {
+                    results->part_one = entry->part_one(parsed);
+                }
+                if (entry->part_two) {
+                    results->part_two = entry->part_two(parsed);
+                }
+                if (cache) {
+                    cache->store(*key, *results);
+                }
+            }
+
+            if (results->part_one) {
+                fmt::print("Part one: {}\n", *results->part_one);
+            }
+            if (results->part_two) {
+                fmt::print("Part two: {}\n", *results->part_two);
+            }
+        }
+    });
+}
+
+}
+
+#if defined(AOC_TRACK_ALLOCS) && !defined(AOC_NO_MAIN)
+// Counting replacements for the global allocation functions. The array and
+// nothrow forms all forward to these by default; the sized deletes are
+// replaced too, so that they don't go straight to the library's. Each block
+// is preceded by a header recording its size, so that delete can find it.
+namespace aoc::instr::detail {
+inline constexpr size_t alloc_header = alignof(std::max_align_t);
+
+// Calls alloc() until it returns non-null, calling the new handler after
+// each failure as the standard asks of operator new, or throws bad_alloc if
+// there is no handler
+template <typename Alloc>
+void* alloc_or_throw(Alloc alloc)
+{
+    while (true) {
+        if (void* raw = alloc()) {
+            return raw;
+        }
+        const auto handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc{};
+        }
+        handler();
+    }
+}
+}
+
+void* operator new(std::size_t size)
+{
+    using aoc::instr::detail::alloc_header;
+    void* raw = aoc::instr::detail::alloc_or_throw([&] { return std::malloc(size + alloc_header); });
+    *static_cast<std::size_t*>(raw) = size;
+    aoc::instr::alloc_stats::on_alloc(size);
+    return static_cast<char*>(raw) + alloc_header;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    using aoc::instr::detail::alloc_header;
+    if (!ptr) {
+        return;
+    }
+    void* raw = static_cast<char*>(ptr) - alloc_header;
+    aoc::instr::alloc_stats::on_free(*static_cast<std::size_t*>(raw));
+    std::free(raw);
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+    using aoc::instr::detail::alloc_header;
+    const auto offset = std::max(static_cast<std::size_t>(align), alloc_header);
+    void* raw = aoc::instr::detail::alloc_or_throw([&] {
+        void* p = nullptr;
+        return ::posix_memalign(&p, offset, size + offset) == 0 ? p : nullptr;
+    });
+    char* ptr = static_cast<char*>(raw) + offset;
+    *reinterpret_cast<std::size_t*>(ptr - alloc_header) = size;
+    aoc::instr::alloc_stats::on_alloc(size);
+    return ptr;
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept
+{
+    using aoc::instr::detail::alloc_header;
+    if (!ptr) {
+        return;
+    }
+    const auto offset = std::max(static_cast<std::size_t>(align), alloc_header);
+    char* p = static_cast<char*>(ptr);
+    aoc::instr::alloc_stats::on_free(*reinterpret_cast<std::size_t*>(p - alloc_header));
+    std::free(p - offset);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept
+{
+    ::operator delete(ptr, align);
+}
+#endif
+
 #endif
@@ -3,9 +3,49 @@
 
 namespace {
 
+constexpr int parse_change(std::string_view word)
+{
+    return aoc::parse_int(word);
+}
+
+// Part one straight from the text, so that it can be done at compile time
+constexpr int sum_changes(std::string_view input)
+{
+    int total = 0;
+    for (const auto word : aoc::words(input)) {
+        total += parse_change(word);
+    }
+    return total;
+}
+
+static_assert(sum_changes("+1 -2 +3 +1") == 3);
+
+int read_change(std::string_view word)
+{
+    const auto change = aoc::try_parse_int(word);
+    if (!change) {
+        aoc::bad_input(fmt::format("'{}' is not a frequency change", word));
+    }
+    return *change;
+}
+
+std::vector<int> read_changes(std::string_view input)
+{
+    std::vector<int> vec;
+
+    for (const auto word : aoc::words(input)) {
+        vec.push_back(read_change(word));
+    }
+
+    if (vec.empty()) {
+        aoc::bad_input("no frequency changes");
+    }
+    return vec;
+}
+
 int part_one(const std::vector<int>& vec)
 {
-    return std::accumulate(vec.cbegin(), vec.cend(), 0);
+    return aoc::reduce(aoc::par_unseq, vec, 0);
 }
 
 int part_two(const std::vector<int>& vec)
@@ -13,7 +53,9 @@ int part_two(const std::vector<int>& vec)
     std::set<int> set{};
     int total = 0;
 
+    // Changes which don't add up to zero may never repeat a frequency
     while (true) {
+        aoc::check_deadline();
         for (int i : vec) {
             total += i;
             if (auto [iter, inserted] = set.insert(total); !inserted) {
@@ -23,19 +65,41 @@ int part_two(const std::vector<int>& vec)
     }
 }
 
+const bool registered = aoc::register_day(1, "dec1", read_changes, part_one, part_two);
+
 }
 
+#ifndef AOC_NO_MAIN
+#ifdef AOC_EMBED_INPUT
+int main()
+{
+    constexpr int pt1 = sum_changes(aoc::embedded_input);
+    fmt::print("Part one: {}\n", pt1);
+    fmt::print("Part two: {}\n", part_two(read_changes(aoc::embedded_input)));
+}
+#else
 int main(int argc, char** argv)
 {
-    if (argc < 2) {
-        std::cerr << "Give me a file to read\n";
-        return -1;
-    }
-
-    using iter_t = nano::istream_iterator<int>;
-    std::ifstream file(argv[1]);
-    const std::vector<int> vec(iter_t{file}, iter_t{});
+    // Part one is just the sum, so add up the changes as they're parsed
+    return aoc::run_main(argc, argv, [](std::string_view input) {
+        aoc::record_stream<int> changes([input](auto&& yield) {
+            for (const auto word : aoc::words(input)) {
+                yield(read_change(word));
+            }
+        });
+        std::vector<int> vec;
+        int total = 0;
+        for (const int change : changes) {
+            total += change;
+            vec.push_back(change);
+        }
+        if (vec.empty()) {
+            aoc::bad_input("no frequency changes");
+        }
 
-    fmt::print("Part 1 result is {}\n", part_one(vec));
-    fmt::print("Part 2 result is {}\n", part_two(vec));
-}
\ No newline at end of file
+        fmt::print("Part one: {}\n", total);
+        fmt::print("Part two: {}\n", part_two(vec));
+    });
+}
+#endif
+#endif
@@ -13,6 +13,18 @@ struct velocity {
     int vy = 0;
 };
 
+template <typename Archive>
+void serialise(Archive& ar, point& p)
+{
+    ar(p.x, p.y);
+}
+
+template <typename Archive>
+void serialise(Archive& ar, velocity& v)
+{
+    ar(v.vx, v.vy);
+}
+
 constexpr point operator+(const point& p, const velocity& v)
 {
     return {p.x + v.vx, p.y + v.vy};
@@ -46,35 +58,103 @@ bounds calculate_bounds(const std::vector<point> pts)
     return b;
 }
 
-void print_points(const std::vector<point>& pts)
+std::string render_points(const std::vector<point>& pts)
 {
     const auto b = calculate_bounds(pts);
-    std::vector<std::string> out(b.height() + 1, std::string(b.width() + 1, ' '));
+    constexpr int64_t max_cells = int64_t{1} << 24;
+    if ((b.width() + 1) * (b.height() + 1) > max_cells) {
+        throw std::runtime_error("The points never come close enough to spell anything");
+    }
+    std::vector<std::string> rows(b.height() + 1, std::string(b.width() + 1, ' '));
 
     for (const point& p : pts) {
-        out[p.y - b.y_min][p.x - b.x_min] = '*';
+        rows[p.y - b.y_min][p.x - b.x_min] = '*';
     }
 
-    nano::copy(out, nano::ostream_iterator<std::string>{std::cout, "\n"});
+    std::string out;
+    for (const auto& row : rows) {
+        out += row;
+        out += '\n';
+    }
+    return out;
 }
 
-std::pair<std::vector<point>, std::vector<velocity>> read_input(std::istream& is)
+std::pair<std::vector<point>, std::vector<velocity>> read_input(std::string_view input)
 {
     std::vector<point> pvec;
     std::vector<velocity> vvec;
-    std::string s;
 
-    while(std::getline(is, s)) {
+    constexpr aoc::pattern input_pattern{"position=<{}, {}> velocity=<{}, {}>"};
+
+    for (const auto line : aoc::lines(input)) {
         point p{};
         velocity v{};
-        std::sscanf(s.c_str(), "position=<%lld, %lld> velocity=<%d, %d>", &p.x, &p.y, &v.vx, &v.vy);
+        input_pattern.scan_or_throw(line, p.x, p.y, v.vx, v.vy);
+        constexpr int64_t max_coord = int64_t{1} << 30;
+        const auto in_range = [](int64_t i) { return i >= -max_coord && i <= max_coord; };
+        if (!in_range(p.x) || !in_range(p.y) || !in_range(v.vx) || !in_range(v.vy)) {
+            aoc::bad_input(fmt::format("'{}' is out of range", line));
+        }
         pvec.push_back(std::move(p));
         vvec.push_back(std::move(v));
     }
 
+    if (pvec.empty()) {
+        aoc::bad_input("no points");
+    }
+    // The search stops when the bounding box starts to grow, which it only
+    // does if the points spread out both across and down
+    const auto all_same = [&vvec](auto proj) {
+        return nano::all_of(vvec, [&](const velocity& v) { return proj(v) == proj(vvec[0]); });
+    };
+    if (all_same([](const velocity& v) { return v.vx; }) ||
+        all_same([](const velocity& v) { return v.vy; })) {
+        aoc::bad_input("the points never spread out, so they never converge either");
+    }
+
     return {std::move(pvec), std::move(vvec)};
 }
 
+using input_t = std::pair<std::vector<point>, std::vector<velocity>>;
+
+// Moves the points until their bounding box is as small as possible, and
+// returns their positions at that time along with the number of seconds taken
+std::pair<std::vector<point>, int> find_message(const input_t& input)
+{
+    auto points = input.first;
+    const auto& velocities = input.second;
+
+    auto size = calculate_bounds(points).size();
+    int iter_counter = 0;
+
+    while (true) {
+        aoc::check_deadline();
+
+        // "Process" one second
+        aoc::transform(aoc::par_unseq, points, velocities, points.begin(), std::plus<>{});
+        const auto new_size = calculate_bounds(points).size();
+
+        if  (new_size > size) {
+            // "Untransform" the vector
+            aoc::transform(aoc::par_unseq, points, velocities, points.begin(), std::minus<>{});
+            return {std::move(points), iter_counter};
+        }
+
+        size = new_size;
+        ++iter_counter;
+    }
+}
+
+std::string part_one(const input_t& input)
+{
+    return render_points(find_message(input).first);
+}
+
+int part_two(const input_t& input)
+{
+    return find_message(input).second;
+}
+
 constexpr auto& test_data = R"(position=< 9,  1> velocity=< 0,  2>
 position=< 7,  0> velocity=<-1,  0>
 position=< 3, -2> velocity=<-1,  1>
@@ -107,40 +187,15 @@ position=< 5,  9> velocity=< 1, -2>
 position=<14,  7> velocity=<-2,  0>
 position=<-3,  6> velocity=< 2, -1>)";
 
+const bool registered = aoc::register_day(10, "dec10", read_input, part_one, part_two);
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
-#if 1
-    if (argc < 2) {
-        fmt::print(stderr, "Need data\n");
-        return -1;
-    }
+    assert(part_two(read_input(test_data)) == 3);
 
-    std::fstream file(argv[1]);
-    auto [points, velocities] = read_input(file);
-#else
-    std::istringstream iss(test_data);
-    auto [points, velocities] = read_input(iss);
+    return aoc::run_main(argc, argv, 10);
+}
 #endif
-
-    auto size = calculate_bounds(points).size();
-    int iter_counter = 0;
-
-    while (true) {
-        // "Process" one second
-        nano::transform(points, velocities, points.begin(), std::plus<>{});
-        const auto new_size = calculate_bounds(points).size();
-
-        if  (new_size > size) {
-            // "Untransform" the vector
-            nano::transform(points, velocities, points.begin(), std::minus<>{});
-            print_points(points);
-            fmt::print("Found a solution after {} seconds\n", iter_counter);
-            break;
-        }
-
-        size = new_size;
-        ++iter_counter;
-    }
-}
\ No newline at end of file
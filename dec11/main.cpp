@@ -1,8 +1,9 @@
 
-#include <array>
+#include "../common.hpp"
+
 #include <cstdint>
 #include <cstdio>
-#include <tuple>
+#include <cstdlib>
 
 namespace {
 
@@ -117,26 +118,41 @@ static_assert(find_largest_square(90, 269, grid18) == std::tuple{16, 113});
 static_assert(find_largest_square(232, 251, grid42) == std::tuple{12, 119});
 #endif
 
+struct square {
+    int power = 0;
+    int x = 0;
+    int y = 0;
+    int size = 0;
+};
+
+// Returns whichever has the greater power, preferring the first
+constexpr auto best_of = [](const square& a, const square& b) {
+    return b.power > a.power ? b : a;
+};
+
+constexpr square best_square_in_row(const int i, const grid& grid)
+{
+    square best{};
+
+    for (int j = 1; j < size; j++) {
+        const auto [sz, pow] = find_largest_square(i, j, grid);
+        best = best_of(best, square{pow, i, j, sz});
+    }
+
+    return best;
+}
+
 constexpr std::tuple<int, int, int>
 part_two(const int serial)
 {
-    std::tuple<int, int, int> out{0, 0, 0};
-    int max_power = 0;
+    square best{};
     const auto grid = calculate_grid(serial);
 
     for (int i = 1; i < size; i++) {
-        for (int j = 1; j < size; j++) {
-            const auto [sz, pow] = find_largest_square(i, j, grid);
-            if (pow > max_power) {
-                std::get<0>(out) = i;
-                std::get<1>(out) = j;
-                std::get<2>(out) = sz;
-                max_power = pow;
-            }
-        }
+        best = best_of(best, best_square_in_row(i, grid));
     }
 
-    return out;
+    return {best.x, best.y, best.size};
 }
 
 #ifdef TESTING
@@ -144,23 +160,68 @@ static_assert(part_two(18) == std::tuple{90, 269, 16});
 static_assert(part_two(42) == std::tuple{232, 251, 12});
 #endif
 
+// As part_two() above, but with the rows searched in parallel at run time
+std::tuple<int, int, int> part_two_parallel(const int serial)
+{
+    const auto grid = calculate_grid(serial);
+    const auto best = aoc::parallel_reduce(1, size, square{}, best_of,
+                                           [&grid](int i) { return best_square_in_row(i, grid); });
+    return {best.x, best.y, best.size};
 }
 
-int main(int argc, char** argv)
+int read_serial(std::string_view input)
 {
-    if (argc < 2) {
-        std::printf("Give me a serial number\n");
-        return -1;
+    // calculate_cell_power() multiplies the serial by up to 310
+    constexpr int max_serial = 1'000'000;
+    const auto serial = aoc::try_parse_int(aoc::trim(input));
+    if (!serial || *serial < 0 || *serial > max_serial) {
+        aoc::bad_input("expected a grid serial number");
     }
+    return *serial;
+}
 
-    const int serial = std::atoi(argv[1]);
-    {
+const bool registered = aoc::register_day(11, "dec11", read_serial,
+    [](int serial) {
+        const auto [x, y] = part_one(serial);
+        return fmt::format("{},{}", x, y);
+    },
+    [](int serial) {
+        const auto [x, y, s] = part_two_parallel(serial);
+        return fmt::format("{},{},{}", x, y, s);
+    });
+
+const bool registered_reference = aoc::register_reference(11, "dec11", read_serial,
+    [](int serial) {
         const auto [x, y] = part_one(serial);
-        std::printf("Serial %d has max at (%d,%d)\n", serial, x, y);
+        return fmt::format("{},{}", x, y);
+    },
+    [](int serial) {
+        const auto [x, y, s] = part_two(serial);
+        return fmt::format("{},{},{}", x, y, s);
+    });
+
+}
+
+#ifndef AOC_NO_MAIN
+#ifdef AOC_EMBED_INPUT
+// Part two is constexpr too, but takes far too long to run in the compiler
+int main()
+{
+    constexpr int serial = aoc::parse_int(aoc::trim(aoc::embedded_input));
+    {
+        constexpr auto pt1 = part_one(serial);
+        fmt::print("Part one: {},{}\n", std::get<0>(pt1), std::get<1>(pt1));
     }
 
     {
-        const auto [x, y, s] = part_two(serial);
-        std::printf("Part two: %d,%d,%d\n", x, y, s);
+        const auto [x, y, s] = part_two_parallel(serial);
+        fmt::print("Part two: {},{},{}\n", x, y, s);
     }
-}
\ No newline at end of file
+}
+#else
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, 11);
+}
+#endif
+#endif
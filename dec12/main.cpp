@@ -7,25 +7,51 @@
 namespace {
 
 struct plants {
-    explicit plants(std::istream& is)
+    explicit plants(std::string_view input)
     {
-        std::string s;
-        std::getline(is, s);
-
-        for (char c : s.substr(15)) {
+        const auto is_pot = [](char c) { return c == '#' || c == '.'; };
+        const auto lines = aoc::lines(input);
+        auto iter = lines.begin();
+
+        constexpr aoc::pattern initial_pattern{"initial state: {}"};
+        std::string_view initial;
+        if (iter == lines.end()) {
+            aoc::bad_input("no initial state");
+        }
+        initial_pattern.scan_or_throw(*iter++, initial);
+        if (!nano::all_of(initial, is_pot)) {
+            aoc::bad_input(fmt::format("'{}' is not a row of pots", initial));
+        }
+        for (char c : initial) {
             deque_.push_back(c == '#');
         }
 
-        std::getline(is, s); // ignore blank line
+        if (iter != lines.end()) {
+            ++iter; // ignore blank line
+        }
 
-        while (std::getline(is, s)) {
+        constexpr aoc::pattern rule_pattern{"{} => {}"};
+        for (; iter != lines.end(); ++iter) {
+            const auto s = *iter;
+            std::string_view from;
+            char to = 0;
+            rule_pattern.scan_or_throw(s, from, to);
+            if (from.size() != 5 || !nano::all_of(from, is_pot) || !is_pot(to)) {
+                aoc::bad_input(fmt::format("'{}' is not a rule", s));
+            }
             uint8_t idx = 0;
             for (int i = 0; i < 5; i++) {
-                if (s[i] == '#') {
+                if (from[i] == '#') {
                     idx += (1 << i);
                 }
             }
-            mapping_[idx] = (s[9] == '#');
+            mapping_[idx] = (to == '#');
+        }
+
+        // An empty pot with empty neighbours has to stay empty, or plants
+        // would spring up all the way along the infinite row
+        if (mapping_[0]) {
+            aoc::bad_input("plants grow from nothing");
         }
     }
 
@@ -38,12 +64,12 @@ struct plants {
         return out;
     }
 
-    int get_sum() const
+    int64_t get_sum() const
     {
-        int total = 0;
+        int64_t total = 0;
         for (size_t i = 0; i < deque_.size(); ++i) {
             if (deque_[i]) {
-                total += i - offset_;
+                total += static_cast<int64_t>(i) - offset_;
             }
         }
 
@@ -81,6 +107,11 @@ private:
     void trim()
     {
         auto iter = nano::find(deque_, true);
+        if (iter == deque_.end()) {
+            // Every plant has died
+            deque_.clear();
+            return;
+        }
         offset_ -= nano::distance(deque_.begin(), iter);
         deque_.erase(deque_.begin(), iter);
 
@@ -93,7 +124,7 @@ private:
     int offset_ = 0;
 };
 
-int get_sum_after(plants p, int generations)
+int64_t get_sum_after(plants p, int generations)
 {
     while (generations-- > 0) {
         p.process();
@@ -101,6 +132,47 @@ int get_sum_after(plants p, int generations)
     return p.get_sum();
 }
 
+// Hypothesis: eventually we fall into a steady state, adding a constant number
+// of plants each generation
+struct steady_state {
+    int64_t diff = 0;
+    int generations = 0;
+    int64_t sum = 0;
+};
+
+steady_state find_steady_state(const plants& orig)
+{
+    const int64_t diff = [&] {
+        const int gen = 1000;
+        return get_sum_after(orig, gen+1) - get_sum_after(orig, gen);
+    }();
+
+    // Okay, so now we need to iterate through until we reach the steady state
+    plants p = orig;
+    int64_t last_sum = p.get_sum();
+    int iterations = 0;
+
+    while (true) {
+        p.process();
+        ++iterations;
+        const int64_t sum = p.get_sum();
+        if (sum - last_sum == diff) {
+            last_sum = sum;
+            break;
+        }
+        last_sum = sum;
+    }
+
+    return {diff, iterations, last_sum};
+}
+
+constexpr auto target_gens = 50'000'000'000;
+
+int64_t extrapolate(const steady_state& steady)
+{
+    return steady.sum + (target_gens - steady.generations) * steady.diff;
+}
+
 constexpr auto& test_data = R"(initial state: #..#.#..##......###...###
 
 ...## => #
@@ -118,56 +190,40 @@ constexpr auto& test_data = R"(initial state: #..#.#..##......###...###
 ###.# => #
 ####. => #)";
 
-}
+struct solver {
+    static plants parse(std::string_view input)
+    {
+        return plants(input);
+    }
 
-int main(int argc, char** argv)
-{
-#if 1
-    std::fstream is(argv[1]);
-#else
-    std::istringstream is{test_data};
-#endif
+    static int64_t part_one(const plants& p)
+    {
+        // 20 generations
+        return get_sum_after(p, 20);
+    }
 
-    const plants orig(is);
+    static int64_t part_two(const plants& p)
+    {
+        // 50 billion generations
+        return extrapolate(find_steady_state(p));
+    }
+};
 
-    // Part one: 20 generations
-    fmt::print("After 20 generations, sum was {}\n", get_sum_after(orig, 20));
+static_assert(aoc::is_solver_v<solver>);
+static_assert(!aoc::is_solver_v<plants>);
+static_assert(std::is_same_v<aoc::solver_traits<solver>::input_type, plants>);
+static_assert(std::is_same_v<aoc::solver_traits<solver>::part_one_type, int64_t>);
+static_assert(std::is_same_v<aoc::solver_traits<solver>::part_two_type, int64_t>);
 
-    // Part two: 50 billion generations
-    {
-        // Hypothesis: eventually we fall into a steady state, adding a constant number
-        // of plants each generation
-        const int diff = [&] {
-            const int gen = 1000;
-            return get_sum_after(orig, gen+1) - get_sum_after(orig, gen);
-        }();
-
-        fmt::print("Eventually we seem to be adding {} plants every generation\n", diff);
-
-        // Okay, so now we need to iterate through until we reach the steady state
-        const auto [steady_gens, steady_sum] = [&] {
-            plants p = orig;
-            int last_sum = p.get_sum();
-            int iterations = 0;
-
-            while (true) {
-                p.process();
-                ++iterations;
-                const int sum = p.get_sum();
-                if (sum - last_sum == diff) {
-                    last_sum = sum;
-                    break;
-                }
-                last_sum = sum;
-            }
-            return std::pair{iterations, last_sum};
-        }();
+const bool registered = aoc::register_solver<solver>(12, "dec12");
+
+}
 
-        fmt::print("It seems we reached a steady state after {} generations, when the sum was {}\n", steady_gens, steady_sum);
-        const auto target_gens = 50'000'000'000;
-        const auto calculated = steady_sum + (target_gens - steady_gens) * diff;
-        //const auto actual = get_sum_after(orig, target_gens);
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    assert(aoc::solve<solver>(test_data).part_one == 325);
 
-        fmt::print("Calculated sum after {} generations was {}\n", target_gens, calculated);
-    }
+    return aoc::run_main(argc, argv, 12);
 }
+#endif
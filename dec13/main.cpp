@@ -77,7 +77,7 @@ constexpr char to_char(const track& t)
     ), t);
 }
 
-using network_t = std::vector<std::vector<track>>;
+using network_t = aoc::grid<track>;
 
 namespace isect {
     struct left {};
@@ -102,7 +102,10 @@ public:
 
     void update(const network_t& network)
     {
-        const auto& t = network[pos_.y][pos_.x];
+        if (!network.contains(pos_.x, pos_.y)) {
+            throw std::runtime_error(fmt::format("Cart ran off the map at {},{}", pos_.x, pos_.y));
+        }
+        const auto& t = network(pos_.x, pos_.y);
         std::visit(make_visitor(
             [this](dir::north, track_type::ns, auto) { move_north(); },
             [this](dir::north, track_type::curve_ne, auto) { move_west(); },
@@ -147,7 +150,7 @@ private:
     void move_south() { dir_ = dir::south{}; ++pos_.y; }
     void move_west() { dir_ = dir::west{}; --pos_.x; }
 
-    static inline int id_counter_ = 0;
+    static inline std::atomic<int> id_counter_{0};
     position pos_{};
     direction dir_{};
     isect_dir next_dir_ = isect::left{};
@@ -163,11 +166,13 @@ bool collision(const cart& a, const cart& b)
 
 class state {
 public:
-    explicit state(std::istream& is);
+    explicit state(std::string_view input);
 
     position process_till_collision()
     {
         while (true) {
+            // Carts on separate loops may never meet
+            aoc::check_deadline();
             sort_carts();
 
             for (auto& c : carts_) {
@@ -182,6 +187,7 @@ public:
 
     void process_tick()
     {
+        AOC_SCOPED_TIMER("process_tick");
         sort_carts();
 
         for (auto& c : carts_) {
@@ -191,6 +197,7 @@ public:
 
             c.update(network_);
 
+            AOC_COUNT("process_tick collisions checked", carts_.size());
             for (auto& other : carts_) {
                 if (collision(c, other)) {
                     c.active = false;
@@ -205,13 +212,9 @@ public:
 
     std::string to_string() const
     {
-        std::vector<std::string> strings;
-        nano::transform(network_, nano::back_inserter(strings), [](const auto& row) {
-            std::string str;
-            nano::transform(row, nano::back_inserter(str), [](const auto& t) {
-                return to_char(t);
-            });
-            return str;
+        std::vector<std::string> strings(network_.height(), std::string(network_.width(), ' '));
+        network_.for_each([&strings](int x, int y, const track& t) {
+            strings[y][x] = to_char(t);
         });
 
        for (const auto& c : carts_) {
@@ -241,38 +244,74 @@ private:
     std::vector<cart> carts_;
 };
 
-inline state::state(std::istream& is)
+inline state::state(std::string_view input)
 {
-    std::string s;
+    // Lines needn't all be the same length, so find the widest first;
+    // the grid is padded out with empty track
+    std::vector<std::string_view> lines;
+    size_t width = 0;
+    for (const auto line : aoc::lines(input)) {
+        lines.push_back(line);
+        width = std::max(width, line.size());
+    }
+    if (lines.empty()) {
+        aoc::bad_input("no tracks");
+    }
+    network_ = network_t(int(width), int(lines.size()), track_type::none{});
 
-    for (int j = 0; std::getline(is, s); j++)
-    {
-        for (size_t i = 0; i < s.size(); i++) {
-            char& c = s[i];
+    for (size_t j = 0; j < lines.size(); j++) {
+        const auto line = lines[j];
+        for (size_t i = 0; i < line.size(); i++) {
+            char c = line[i];
             switch (c){
             case '^': carts_.emplace_back(i, j, dir::north{});  c = '|'; break;
             case '>': carts_.emplace_back(i, j, dir::east{});  c = '-';  break;
             case 'v': carts_.emplace_back(i, j, dir::south{}); c = '|'; break;
             case '<': carts_.emplace_back(i, j, dir::west{}); c = '-';  break;
             }
+
+            network_(i, j) = [&] () -> track {
+                switch (c) {
+                case '-': return track_type::ew{};
+                case '|': return track_type::ns{};
+                case '/': return track_type::curve_se{};
+                case '\\': return track_type::curve_ne{};
+                case '+': return track_type::isect{};
+                case ' ': return track_type::none{};
+                default:
+                    aoc::bad_input(fmt::format("unknown track type '{}'", c));
+                }
+            }();
         }
+    }
 
-        std::vector<track> line;
-        nano::transform(s, nano::back_inserter(line), [&] (const char c) -> track {
-            switch (c) {
-            case '-': return track_type::ew{};
-            case '|': return track_type::ns{};
-            case '/': return track_type::curve_se{};
-            case '\\': return track_type::curve_ne{};
-            case '+': return track_type::isect{};
-            case ' ': return track_type::none{};
-            default:
-                throw std::runtime_error(fmt::format("Unknown track type '{}'", c));
-            }
-        });
+    if (carts_.size() < 2) {
+        aoc::bad_input("fewer than two carts, so nothing can crash");
+    }
+}
 
-        network_.push_back(std::move(line));
+position part_one(const state& initial)
+{
+    auto state = initial;
+    return state.process_till_collision();
+}
+
+position part_two(const state& initial)
+{
+    auto state = initial;
+    while (state.get_carts().size() > 1) {
+        aoc::check_deadline();
+        state.process_tick();
     }
+    if (state.get_carts().empty()) {
+        throw std::runtime_error("Every cart crashed");
+    }
+    return state.get_carts().front().get_position();
+}
+
+std::string to_string(const position& pos)
+{
+    return fmt::format("{},{}", pos.x, pos.y);
 }
 
 constexpr auto& test_input =
@@ -292,19 +331,26 @@ R"(/>-<\
   |   ^
   \<->/)";
 
+const bool registered = aoc::register_day(13, "dec13", [](std::string_view input) {
+    return state{input};
+}, [](const state& s) {
+    return to_string(part_one(s));
+}, [](const state& s) {
+    return to_string(part_two(s));
+});
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
     // Tests
     {
-        std::istringstream is{test_input};
-        assert((state{is}.process_till_collision() == position{7, 3}));
+        assert((state{test_input}.process_till_collision() == position{7, 3}));
     }
 
     {
-        std::istringstream is{test_input2};
-        state s{is};
+        state s{test_input2};
         while(s.get_carts().size() > 1) {
             s.process_tick();
         }
@@ -312,29 +358,6 @@ int main(int argc, char** argv)
         assert((s.get_carts().front().get_position() == position{6, 4}));
     }
 
-    if (argc < 2) {
-        fmt::print(stderr, "Please provide some input\n");
-        return 1;
-    }
-
-    std::ifstream is{argv[1]};
-    const state initial{is};
-
-    // Part one
-    {
-        auto state = initial;
-        const auto pos = state.process_till_collision();
-        fmt::print("Part one: got collision at {},{}\n", pos.x, pos.y);
-    }
-
-    // Part two
-    {
-        auto state = initial;
-        while (state.get_carts().size() > 1) {
-            state.process_tick();
-        }
-        assert(!state.get_carts().empty());
-        const auto pos = state.get_carts().front().get_position();
-        fmt::print("Part two: last remaining cart has position {},{}\n", pos.x, pos.y);
-    }
-}
\ No newline at end of file
+    return aoc::run_main(argc, argv, 13);
+}
+#endif
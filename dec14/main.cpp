@@ -1,7 +1,6 @@
 
 #include "../common.hpp"
 
-#include <charconv>
 
 namespace {
 
@@ -33,11 +32,15 @@ void advance(size_t& cur, size_t dist, const size_t max)
 
 auto part_one(size_t target_iters)
 {
-    std::vector<uint8_t> scores{3, 7};
+    aoc::large_vector<uint8_t> scores{3, 7};
+    scores.reserve(target_iters + 11);
     size_t pos1 = 0;
     size_t pos2 = 1;
 
     while (scores.size() < target_iters + 10) {
+        if ((scores.size() & 0xffff) == 0) {
+            aoc::check_deadline();
+        }
         uint8_t new_score = scores[pos1] + scores[pos2];
 
         if (new_score >= 10) {
@@ -68,14 +71,29 @@ size_t part_two(std::string_view target_str)
     }();
     const auto target_size = target_vec.size();
 
-    std::vector<uint8_t> scores{3, 7};
+    aoc::large_vector<uint8_t> scores{3, 7};
     size_t pos1 = 0;
     size_t pos2 = 1;
 
     while (true) {
+        // The target may never turn up
+        if ((scores.size() & 0xffff) == 0) {
+            aoc::check_deadline();
+        }
         uint8_t new_score = scores[pos1] + scores[pos2];
 
-        if (new_score >= 10) {
+        if (scores.size() < target_size + 1) {
+            // Too short to hold the target plus the extra digit we search
+            // below, so just check for it naively
+            if (new_score >= 10) {
+                scores.push_back(new_score/10);
+            }
+            scores.push_back(new_score % 10);
+            const auto sub = nano::search(scores, target_vec);
+            if (!sub.empty()) {
+                return nano::distance(scores.begin(), sub.begin());
+            }
+        } else if (new_score >= 10) {
             scores.push_back(new_score/10);
             scores.push_back(new_score % 10);
 
@@ -96,19 +114,33 @@ size_t part_two(std::string_view target_str)
     }
 }
 
-std::optional<size_t> to_size_t(const char* const str)
+std::string read_target(std::string_view input)
 {
-    const auto last = str + std::strlen(str);
-    size_t out = 0;
-    const auto res = std::from_chars(str, last, out);
-    if (res.ptr != last) {
-        return std::nullopt;
+    input = aoc::trim(input);
+    if (input.empty()) {
+        aoc::bad_input("no puzzle input");
     }
-    return out;
+    // Part one needs a recipe per unit of the input, so keep that bounded
+    if (input.size() > 8) {
+        aoc::bad_input(fmt::format("'{}' is too long", input));
+    }
+    if (!nano::all_of(input, [](char c) { return c >= '0' && c <= '9'; })) {
+        aoc::bad_input(fmt::format("'{}' is not a number", input));
+    }
+    return std::string(input);
 }
 
+const bool registered = aoc::register_day(14, "dec14", [](std::string_view input) {
+    return read_target(input);
+}, [](const std::string& input) {
+    return part_one(*aoc::try_parse_int<size_t>(input));
+}, [](const std::string& input) {
+    return part_two(input);
+});
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
     assert(part_one(9) == "5158916779");
@@ -121,17 +153,8 @@ int main(int argc, char** argv)
     assert(part_two("92510") == 18);
     assert(part_two("59414") == 2018);
 
-    if (argc < 2) {
-        fmt::print(stderr, "No input\n");
-        return 1;
-    }
-
-    const auto target = to_size_t(argv[1]);
-    if (!target) {
-        fmt::print(stderr, "Argument was not a number\n");
-        return 2;
-    }
-
-    fmt::print("Part one: after {} recipes, the next ten were {}\n", *target, part_one(*target));
-    fmt::print("Part two: before the sequence {}, the number of recipes was {}\n", argv[1], part_two(argv[1]));
-}
\ No newline at end of file
+    // Build with -DAOC_INSTRUMENT (and with or without -DSHORT_ADVANCE) to
+    // compare the hardware counters for the two versions of advance()
+    return aoc::run_main(argc, argv, 14);
+}
+#endif
@@ -84,12 +84,15 @@ constexpr std::array<op_t, 16> operations = {
     op::eqir, op::eqri, op::eqrr
 };
 
-state_t parse_state(const std::string& str)
+state_t parse_state(std::string_view str)
 {
-    constexpr auto& format_str = "[%u, %u, %u, %u]";
-    const auto pos = str.find('[');
-    state_t state;
-    std::sscanf(str.c_str() + pos, format_str, &state[0], &state[1], &state[2], &state[3]);
+    constexpr aoc::pattern state_pattern{"[{}, {}, {}, {}]"};
+    const auto bracket = str.find('[');
+    if (bracket == std::string_view::npos) {
+        aoc::bad_input(fmt::format("'{}' is not a register state", str));
+    }
+    state_t state{};
+    state_pattern.scan_or_throw(str.substr(bracket), state[0], state[1], state[2], state[3]);
     return state;
 }
 
@@ -102,11 +105,21 @@ struct instruction {
     uint32_t a, b, c;
 };
 
-instruction parse_instruction(const std::string& str)
+template <typename Archive>
+void serialise(Archive& ar, instruction& i)
+{
+    ar(i.opcode, i.a, i.b, i.c);
+}
+
+instruction parse_instruction(std::string_view str)
 {
-    constexpr auto& format_str = "%u %u %u %u";
-    instruction i;
-    std::sscanf(str.c_str(), format_str, &i.opcode, &i.a, &i.b, &i.c);
+    constexpr aoc::pattern instruction_pattern{"{} {} {} {}"};
+    instruction i{};
+    instruction_pattern.scan_or_throw(str, i.opcode, i.a, i.b, i.c);
+    // Every operand is used as a register index by some operation
+    if (i.opcode >= operations.size() || nano::max({i.a, i.b, i.c}) >= std::tuple_size_v<state_t>) {
+        aoc::bad_input(fmt::format("'{}' is not a valid instruction", str));
+    }
     return i;
 }
 
@@ -126,51 +139,70 @@ struct sample {
     state_t post;
 };
 
+template <typename Archive>
+void serialise(Archive& ar, sample& s)
+{
+    ar(s.pre, s.inst, s.post);
+}
+
 using sample_stream = std::vector<sample>;
 
-sample_stream parse_samples(std::istream& is)
+// Calls yield(sample) for each sample in the input, in order
+template <typename Yield>
+void for_each_sample(std::string_view input, Yield&& yield)
 {
-    sample_stream stream;
-    std::string s;
+    const auto lines = aoc::lines(input);
+    auto iter = lines.begin();
+    const auto last = lines.end();
 
     while (true) {
-        if (!std::getline(is, s)) break;
-        const state_t pre_state = parse_state(s);
+        if (iter == last) break;
+        const state_t pre_state = parse_state(*iter++);
 
-        if (!std::getline(is, s)) break;
-        const instruction i = parse_instruction(s);
+        if (iter == last) break;
+        const instruction i = parse_instruction(*iter++);
 
-        if (!std::getline(is, s)) break;
-        const state_t post_state = parse_state(s);
+        if (iter == last) break;
+        const state_t post_state = parse_state(*iter++);
 
-        stream.push_back(sample{pre_state, i, post_state});
+        yield(sample{pre_state, i, post_state});
 
-        if (!std::getline(is, s)) break;
+        if (iter == last) break;
+        ++iter;
     }
+}
 
+sample_stream parse_samples(std::string_view input)
+{
+    sample_stream stream;
+    for_each_sample(input, [&stream](const sample& s) { stream.push_back(s); });
+    if (stream.empty()) {
+        aoc::bad_input("no samples");
+    }
     return stream;
 }
 
-int part_one(const sample_stream& ss)
+bool matches_three_or_more(const sample& s)
 {
-    int match3_count = 0;
-
-    for (const auto& s : ss) {
-        int match_count = 0;
-        for (const auto& func : operations) {
-            state_t state = s.pre;
-            func(state, s.inst.a, s.inst.b, s.inst.c);
-            if (state == s.post) {
-                ++match_count;
-            }
-            if (match_count >= 3) {
-                ++match3_count;
-                break;
-            }
+    int match_count = 0;
+    for (const auto& func : operations) {
+        state_t state = s.pre;
+        func(state, s.inst.a, s.inst.b, s.inst.c);
+        if (state == s.post) {
+            ++match_count;
+        }
+        if (match_count >= 3) {
+            return true;
         }
     }
+    return false;
+}
 
-    return match3_count;
+int part_one(const sample_stream& ss)
+{
+    return aoc::parallel_reduce(size_t{0}, ss.size(), 0, std::plus<>{}, [&](size_t i) {
+        return matches_three_or_more(ss[i]) ? 1 : 0;
+    });
 }
 
 struct possbilities_matrix {
@@ -249,13 +281,15 @@ opcode_map build_opcode_map(const sample_stream& ss)
 
 using instruction_stream = std::vector<instruction>;
 
-instruction_stream parse_instruction_stream(std::istream& is)
+instruction_stream parse_instruction_stream(std::string_view input)
 {
     instruction_stream out;
-    std::string s;
 
-    while (std::getline(is, s)) {
-        out.push_back(parse_instruction(s));
+    for (const auto line : aoc::lines(input)) {
+        out.push_back(parse_instruction(line));
+    }
+    if (out.empty()) {
+        aoc::bad_input("no test program");
     }
 
     return out;
@@ -270,22 +304,68 @@ state_t process_instruction_stream(const instruction_stream& is, const opcode_ma
     return state;
 }
 
+uint32_t part_two(const sample_stream& ss, const instruction_stream& is)
+{
+    const auto map = build_opcode_map(ss);
+    return process_instruction_stream(is, map)[0];
 }
 
-int main(int argc, char** argv)
+struct puzzle_input {
+    sample_stream samples;
+    instruction_stream program;
+};
+
+template <typename Archive>
+void serialise(Archive& ar, puzzle_input& in)
 {
-    if (argc < 3) {
-        fmt::print(stderr, "Expect two arguments: a file with samples (part one), and a file with instructions (part two)");
-        return 1;
-    }
+    ar(in.samples, in.program);
+}
+
+// The full puzzle input is the samples, followed by three blank lines,
+// followed by the test program
+std::pair<std::string_view, std::string_view> split_input(std::string_view input)
+{
+    const auto split = nano::min(input.find("\n\n\n"), input.size());
+    return {input.substr(0, split), aoc::trim(input.substr(split))};
+}
+
+puzzle_input parse_input(std::string_view input)
+{
+    const auto [samples, program] = split_input(input);
+    return {parse_samples(samples), parse_instruction_stream(program)};
+}
+
+const bool registered = aoc::register_day(16, "dec16", parse_input, [](const puzzle_input& in) {
+    return part_one(in.samples);
+}, [](const puzzle_input& in) {
+    return part_two(in.samples, in.program);
+});
 
-    std::fstream is1(argv[1]);
-    const auto stream = parse_samples(is1);
-    fmt::print("Part one: {} instructions match 3 or more opcodes\n", part_one(stream));
+}
 
-    const auto map = build_opcode_map(stream);
-    std::fstream is2(argv[2]);
-    const auto istream = parse_instruction_stream(is2);
-    const auto final_state = process_instruction_stream(istream, map);
-    fmt::print("Part two: final value of register 0 was {}\n", final_state[0]);
-}
\ No newline at end of file
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, [](std::string_view text) {
+        const auto [samples_text, program_text] = split_input(text);
+
+        // Part one looks at each sample on its own, so test them as they're parsed
+        aoc::record_stream<sample> samples([samples_text = samples_text](auto&& yield) {
+            for_each_sample(samples_text, yield);
+        });
+        puzzle_input input;
+        int match_count = 0;
+        for (const sample& s : samples) {
+            match_count += matches_three_or_more(s);
+            input.samples.push_back(s);
+        }
+        if (input.samples.empty()) {
+            aoc::bad_input("no samples");
+        }
+        input.program = parse_instruction_stream(program_text);
+
+        fmt::print("Part one: {}\n", match_count);
+        fmt::print("Part two: {}\n", part_two(input.samples, input.program));
+    });
+}
+#endif
@@ -8,14 +8,14 @@ struct repeat_info {
     bool has_three = false;
 };
 
-repeat_info count_freqs(const std::string& str)
+repeat_info count_freqs(std::string_view str)
 {
     std::array<int, 26> freqs{};
     for (const char c : str) {
         ++freqs[c - 'a'];
     }
 
-    repeat_count r{};
+    repeat_info r{};
     for (const int i : freqs) {
         if (i == 2) {
             r.has_two = true;
@@ -27,24 +27,64 @@ repeat_info count_freqs(const std::string& str)
     return r;
 }
 
+std::string_view check_id(std::string_view id)
+{
+    if (!nano::all_of(id, [](char c) { return c >= 'a' && c <= 'z'; })) {
+        aoc::bad_input(fmt::format("'{}' is not a box ID", id));
+    }
+    return id;
 }
 
-int main(int argc, char** argv)
+std::vector<std::string_view> read_ids(std::string_view input)
 {
-    if (argc < 2) {
-        std::cerr << "Give me a file to read\n";
-        return -1;
+    const auto words = aoc::words(input);
+    std::vector<std::string_view> ids(words.begin(), words.end());
+    if (ids.empty()) {
+        aoc::bad_input("no box IDs");
     }
+    nano::for_each(ids, check_id);
+    return ids;
+}
 
-    std::ifstream file(argv[1]);
-    using iter_t = std::istream_iterator<std::string>;
-    const auto input = std::vector(iter_t{file}, iter_t{});
-
+auto part_one(const std::vector<std::string_view>& input)
+{
     std::vector<repeat_info> counts(input.size());
-    nano::transform(input, counts.begin(), count_freqs);
+    aoc::transform(aoc::par, input, counts.begin(), count_freqs);
+
+    const auto two_count = aoc::count_if(aoc::par, counts, &repeat_info::has_two);
+    const auto three_count = aoc::count_if(aoc::par, counts, &repeat_info::has_three);
+
+    return two_count * three_count;
+}
 
-    const auto two_count = nano::count_if(counts, &repeat_info::has_two);
-    const auto three_count = nano::count_if(counts, &repeat_info::has_three);
+const bool registered = aoc::register_day(2, "dec2/pt1", read_ids, part_one, nullptr);
 
-    fmt::print("Part 1 result is {}\n", two_count * three_count);
-}
\ No newline at end of file
+}
+
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    // Count each ID's repeats as it arrives, rather than collecting them first
+    return aoc::run_main(argc, argv, [](std::string_view input) {
+        aoc::record_stream<std::string_view> ids([input](auto&& yield) {
+            for (const auto word : aoc::words(input)) {
+                yield(check_id(word));
+            }
+        });
+        int64_t num_ids = 0;
+        int64_t two_count = 0;
+        int64_t three_count = 0;
+        for (const auto id : ids) {
+            const auto r = count_freqs(id);
+            ++num_ids;
+            two_count += r.has_two;
+            three_count += r.has_three;
+        }
+        if (num_ids == 0) {
+            aoc::bad_input("no box IDs");
+        }
+
+        fmt::print("Part one: {}\n", two_count * three_count);
+    });
+}
+#endif
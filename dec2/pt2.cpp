@@ -3,7 +3,7 @@
 
 namespace {
 
-std::string build_matching_string(const std::string& str1, const std::string& str2)
+std::string build_matching_string(std::string_view str1, std::string_view str2)
 {
     std::string out;
     for (int i = 0; i < str1.size(); ++i) {
@@ -54,18 +54,29 @@ std::string compare_strings(const Cont& cont)
     return "<no matching strings found>";
 }
 
-}
-
-int main(int argc, char** argv)
+std::vector<std::string_view> read_ids(std::string_view input)
 {
-    if (argc < 2) {
-        std::cerr << "Give me a file to read\n";
-        return -1;
+    const auto words = aoc::words(input);
+    std::vector<std::string_view> ids(words.begin(), words.end());
+    if (ids.size() < 2) {
+        aoc::bad_input("fewer than two box IDs");
     }
+    for (const auto id : ids) {
+        if (!nano::all_of(id, [](char c) { return c >= 'a' && c <= 'z'; })) {
+            aoc::bad_input(fmt::format("'{}' is not a box ID", id));
+        }
+    }
+    return ids;
+}
 
-    std::ifstream file(argv[1]);
-    using iter_t = nano::istream_iterator<std::string>;
-    const std::vector input(iter_t(file), iter_t{});
+const bool registered = aoc::register_day(2, "dec2/pt2", read_ids, nullptr,
+                                          compare_strings<std::vector<std::string_view>>);
 
-    fmt::print("Part two result was {}\n", compare_strings(input));
-}
\ No newline at end of file
+}
+
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, 2);
+}
+#endif
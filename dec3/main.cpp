@@ -10,11 +10,17 @@ struct claim {
     int top = 0;
     int bottom = 0;
 
-    static claim parse(const std::string& str)
+    static claim parse(std::string_view str)
     {
+        constexpr aoc::pattern claim_pattern{"#{} @ {},{}: {}x{}"};
         claim c;
-        int width, height;
-        std::sscanf(str.c_str(), "#%d @ %d,%d: %dx%d", &c.id, &c.left, &c.top, &width, &height);
+        int width = 0, height = 0;
+        claim_pattern.scan_or_throw(str, c.id, c.left, c.top, width, height);
+        constexpr int max_extent = 1 << 20;
+        const auto in_range = [](int i) { return i >= 0 && i <= max_extent; };
+        if (!in_range(c.left) || !in_range(c.top) || !in_range(width) || !in_range(height)) {
+            aoc::bad_input(fmt::format("claim #{} is out of range", c.id));
+        }
         c.right = c.left + width;
         c.bottom = c.top + height;
 
@@ -22,6 +28,12 @@ struct claim {
     }
 };
 
+template <typename Archive>
+void serialise(Archive& ar, claim& c)
+{
+    ar(c.id, c.left, c.right, c.top, c.bottom);
+}
+
 bool overlap(const claim& x, const claim& y)
 {
     return y.right > x.left &&
@@ -30,17 +42,17 @@ bool overlap(const claim& x, const claim& y)
            x.bottom > y.top;
 }
 
-std::vector<claim> read_claims(const char* input_file)
+std::vector<claim> read_claims(std::string_view input)
 {
-    std::ifstream file(input_file);
-
     std::vector<claim> claims{};
-    std::string str;
 
-    while (std::getline(file, str)) {
-        claims.push_back(claim::parse(str));
+    for (const auto line : aoc::lines(input)) {
+        claims.push_back(claim::parse(line));
     }
 
+    if (claims.empty()) {
+        aoc::bad_input("no claims");
+    }
     return claims;
 }
 
@@ -57,49 +69,101 @@ void inc_status(claim_status& s)
     s = (s == claim_status::none ? claim_status::single : claim_status::multiple);
 }
 
+void mark_claim(aoc::grid<claim_status>& fabric, const claim& cl)
+{
+    const aoc::grid_rect area{cl.left, cl.top, cl.right - cl.left, cl.bottom - cl.top};
+    fabric.for_each_in(area, [](int, int, claim_status& s) { inc_status(s); });
 }
 
-int main(int argc, char** argv)
+int count_overlaps(const aoc::grid<claim_status>& fabric)
+{
+    int count = 0;
+    fabric.for_each([&count](int, int, claim_status s) {
+        count += (s == claim_status::multiple);
+    });
+    return count;
+}
+
+auto part_one(const std::vector<claim>& claims)
 {
-    if (argc < 2) {
-        std::cerr << "give me an input file";
-        return 1;
+    // Calculate the max values of claims that we have been given
+    // this always seems to be [1000, 1000] or thereabouts, but
+    // it's not explicitly stated in the problem description
+    const auto [width, height] = get_max_values(claims);
+    aoc::grid<claim_status> fabric(width, height, claim_status::none);
+
+    for (const auto& cl : claims) {
+        mark_claim(fabric, cl);
     }
 
-    const auto claims = read_claims(argv[1]);
+    return count_overlaps(fabric);
+}
 
-    // Part one
-    {
-        // Calculate the max values of claims that we have been given
-        // this always seems to be [1000, 1000] or thereabouts, but
-        // it's not explicitly stated in the problem description
-        const auto [width, height] = get_max_values(claims);
-        std::vector<claim_status> fabric(width * height, claim_status::none);
-
-        for (const auto& cl : claims) {
-            for (int i = cl.left; i < cl.right; ++i) {
-                for (int j = cl.top; j < cl.bottom; ++j) {
-                    inc_status(fabric[i * height + j]);
-                }
-            }
-        }
+std::optional<int> part_two(const std::vector<claim>& claims)
+{
+    const auto no_overlap = [&](const auto& x) {
+        return nano::find_if(claims, [x](const auto& y) {
+            return x.id != y.id && overlap(x, y);
+        }) == claims.end();
+    };
+
+    if (const auto iter = nano::find_if(claims, no_overlap); iter != claims.end()) {
+        return iter->id;
+    }
+    return std::nullopt;
+}
+
+const bool registered = aoc::register_day(3, "dec3", read_claims, part_one, part_two);
 
-        fmt::print("{} squares of fabric are within two or more claims\n",
-                  nano::count(fabric, claim_status::multiple));
+}
+
+#ifndef AOC_NO_MAIN
+namespace {
+
+// The size of the fabric isn't known up front when claims arrive from a
+// stream, so regrow the grid (at least doubling) if a claim falls outside
+void fit_claim(aoc::grid<claim_status>& fabric, const claim& cl)
+{
+    if (cl.right <= fabric.width() && cl.bottom <= fabric.height()) {
+        return;
     }
+    const auto grow = [](int size, int needed) {
+        return needed > size ? std::max(needed, 2 * size) : size;
+    };
+    aoc::grid<claim_status> bigger(grow(fabric.width(), cl.right),
+                                   grow(fabric.height(), cl.bottom),
+                                   claim_status::none);
+    fabric.for_each([&bigger](int x, int y, claim_status s) { bigger(x, y) = s; });
+    fabric = std::move(bigger);
+}
 
-    // Part two
-    {
-        const auto no_overlap = [&](const auto& x) {
-            return nano::find_if(claims, [x](const auto& y) {
-                return x.id != y.id && overlap(x, y);
-            }) == claims.end();
-        };
-
-        if (const auto iter = nano::find_if(claims, no_overlap); iter != claims.end()) {
-            fmt::print("Claim #{} does not overlap with any others\n", iter->id);
-        } else {
-            fmt::print("There were no non-overlapping claims\n");
-        }
+// As part_one(), but marking each claim as it arrives from a stream, and
+// keeping the claims for part two
+int part_one_streamed(aoc::record_stream<claim>& stream, std::vector<claim>& claims)
+{
+    aoc::grid<claim_status> fabric(1000, 1000, claim_status::none);
+
+    for (const claim& cl : stream) {
+        fit_claim(fabric, cl);
+        mark_claim(fabric, cl);
+        claims.push_back(cl);
+    }
+    if (claims.empty()) {
+        aoc::bad_input("no claims");
     }
+
+    return count_overlaps(fabric);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, [](std::string_view input) {
+        auto stream = aoc::stream_lines(input, claim::parse);
+        std::vector<claim> claims;
+        fmt::print("Part one: {}\n", part_one_streamed(stream, claims));
+        fmt::print("Part two: {}\n", aoc::to_result_string(part_two(claims)));
+    });
 }
+#endif
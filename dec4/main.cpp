@@ -44,51 +44,48 @@ guard_id get_guard_id(const event& ev)
 
 timestamp parse_time(const std::string_view str)
 {
-    // There *must* be an easier way to do this...
-    int year, month, day, hour, minute;
-    std::sscanf(str.data(), "[%d-%d-%d %d:%d]", &year, &month, &day, &hour, &minute);
+    constexpr aoc::pattern time_pattern{"[{}-{}-{} {}:{}]"};
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    time_pattern.scan_or_throw(str, year, month, day, hour, minute);
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        aoc::bad_input(fmt::format("'{}' is not a time", str.substr(0, str.find(']') + 1)));
+    }
     const auto d =  date::year{year}/date::month(month)/date::day(day);
     return date::sys_days{d} + std::chrono::hours{hour} + std::chrono::minutes{minute};
 }
 
-// All this to avoid using std::regex...
 guard_id parse_guard_id(const std::string_view str)
 {
-    const auto start = nano::next(nano::find(str, '#'));
-    const auto end = nano::find(start, str.end(), ' ');
-
-    int i = 0;
-    std::from_chars(&*start, &*end, i);
-    return guard_id{i};
+    constexpr aoc::pattern guard_pattern{"Guard #{} begins shift"};
+    guard_id id{};
+    guard_pattern.scan_or_throw(str, id);
+    return id;
 }
 
 event parse_event(const std::string_view str)
 {
     const auto time = parse_time(str);
 
-    const auto event_str = str.substr(19);
+    // parse_time() has found the ']'
+    const auto event_str = aoc::trim(str.substr(str.find(']') + 1));
 
-    switch (event_str[0]) {
-    case 'f':
+    if (event_str == "falls asleep") {
         return sleep_event{time};
-    case 'w':
+    }
+    if (event_str == "wakes up") {
         return wake_event{time};
-    case 'G':
-        return start_shift_event{time, parse_guard_id(event_str)};
-    default:
-        assert(false);
     }
+    return start_shift_event{time, parse_guard_id(event_str)};
 }
 
 using event_log = std::vector<event>;
 
-event_log build_event_log(std::istream& is)
+event_log build_event_log(std::string_view input)
 {
     event_log e;
-    std::string s;
 
-    while (std::getline(is, s)) {
-        e.push_back(parse_event(s));
+    for (const auto line : aoc::lines(input)) {
+        e.push_back(parse_event(line));
     }
 
     return e;
@@ -140,7 +137,7 @@ private:
     std::array<int, 60> arr{};
 };
 
-using sleep_log = std::map<guard_id, sleep_record>;
+using sleep_log = std::pmr::map<guard_id, sleep_record>;
 
 template <typename Iter>
 sleep_record calculate_sleep_record(Iter& iter, const Iter last)
@@ -153,13 +150,22 @@ sleep_record calculate_sleep_record(Iter& iter, const Iter last)
         }
 
         // We must be at a sleep event
-        assert(std::holds_alternative<sleep_event>(*iter));
+        if (!std::holds_alternative<sleep_event>(*iter)) {
+            aoc::bad_input("a guard woke up without falling asleep");
+        }
         const auto sleep_start = get_timestamp(*iter);
 
         ++iter;
-        assert(std::holds_alternative<wake_event>(*iter));
+        if (iter == last || !std::holds_alternative<wake_event>(*iter)) {
+            aoc::bad_input("a guard fell asleep and didn't wake up");
+        }
         const auto sleep_end = get_timestamp(*iter);
 
+        // sleep_record only has room for the midnight hour
+        if (sleep_end <= sleep_start || sleep_end - date::floor<date::days>(sleep_start) > 60min) {
+            aoc::bad_input("a guard slept outside the midnight hour");
+        }
+
         rec.add_sleep(sleep_start, sleep_end);
 
         ++iter;
@@ -168,20 +174,22 @@ sleep_record calculate_sleep_record(Iter& iter, const Iter last)
     return rec;
 }
 
-sleep_log build_sleep_log(const event_log& elog)
+sleep_log build_sleep_log(const event_log& elog, std::pmr::memory_resource* mem)
 {
-    sleep_log slog{};
+    sleep_log slog{mem};
 
     auto iter = elog.begin();
     const auto last = elog.end();
 
     while (iter != last) {
         // We must be at a "start shift" event
-        assert(std::holds_alternative<start_shift_event>(*iter));
+        if (!std::holds_alternative<start_shift_event>(*iter)) {
+            aoc::bad_input("a guard fell asleep before any shift began");
+        }
         const auto id = get_guard_id(*iter);
 
         ++iter; // We are now at either a sleep event or a start_shift event
-        if (std::holds_alternative<start_shift_event>(*iter)) {
+        if (iter == last || std::holds_alternative<start_shift_event>(*iter)) {
             continue;
         }
 
@@ -191,57 +199,67 @@ sleep_log build_sleep_log(const event_log& elog)
     return slog;
 }
 
-}
-
-int main(int argc, char** argv)
+sleep_log read_sleep_log(std::string_view input,
+                         std::pmr::memory_resource* mem = std::pmr::get_default_resource())
 {
-#if 1
-    if (argc < 2) {
-        fmt::print(stderr, "Provide me with some input, sir!\n");
-        return -1;
-    }
-
-    std::ifstream is(argv[1]);
-#else
-    std::istringstream is{test_event_log};
-#endif
-
     const auto elog = [&] {
-        auto e = build_event_log(is);
-        nano::sort(e, nano::less<>{}, get_timestamp);
+        auto e = build_event_log(input);
+        aoc::sort(aoc::par, e, nano::less<>{}, get_timestamp);
         return e;
     }();
 
-    const auto slog = build_sleep_log(elog);
+    auto slog = build_sleep_log(elog, mem);
+    if (slog.empty()) {
+        aoc::bad_input("no guard ever fell asleep");
+    }
+    return slog;
+}
 
-    // Part One
-    {
-        const auto& [id, record] = *nano::max_element(slog, nano::less<>{}, [](const auto& p) {
-            return p.second.get_total();
-        });
+int sleepiest_minute(const sleep_record& record)
+{
+    return nano::distance(record.begin(), nano::max_element(record));
+}
 
-        const auto sleepiest_minute = nano::distance(record.begin(), nano::max_element(record));
+// The guard who spent the most minutes asleep overall
+const sleep_log::value_type& sleepiest_guard(const sleep_log& slog)
+{
+    return *nano::max_element(slog, nano::less<>{}, [](const auto& p) {
+        return p.second.get_total();
+    });
+}
 
-        fmt::print("Sleepiest guard was #{} ({} minutes)\n", to_int(id), record.get_total().count());
-        fmt::print("Sleepiest minute was {}\n", sleepiest_minute);
-        fmt::print("Product: {}\n", to_int(id) * sleepiest_minute);
-    }
+// The guard who was most frequently asleep on the same minute
+const sleep_log::value_type& most_regular_guard(const sleep_log& slog)
+{
+    return *nano::max_element(slog, nano::less<>{}, [](const auto& el) {
+        return *nano::max_element(el.second);
+    });
+}
 
-    // Part Two
-    {
-        const auto get_sleepiest_minute = [](const auto& record) {
-            return nano::max_element(record);
-        };
-
-        const auto& [id, record] = *nano::max_element(slog, nano::less<>{}, [&](const auto& el) {
-            return *get_sleepiest_minute(el.second);
-        });
-
-        fmt::print("Guard #{} was most frequently asleep on the same minute\n", to_int(id));
-        const auto minute = nano::distance(record.begin(), get_sleepiest_minute(record));
-        fmt::print("That was minute {}\n", minute);
-        fmt::print("Product: {}\n", to_int(id) * minute);
-    }
+int part_one(const sleep_log& slog)
+{
+    const auto& [id, record] = sleepiest_guard(slog);
+    return to_int(id) * sleepiest_minute(record);
 }
 
+int part_two(const sleep_log& slog)
+{
+    const auto& [id, record] = most_regular_guard(slog);
+    return to_int(id) * sleepiest_minute(record);
+}
+
+const bool registered = aoc::register_day(4, "dec4",
+    [](std::string_view input) { return read_sleep_log(input); },
+    part_one, part_two);
+
+}
 
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    assert(part_one(read_sleep_log(test_event_log)) == 240);
+    assert(part_two(read_sleep_log(test_event_log)) == 4455);
+
+    return aoc::run_main(argc, argv, 4);
+}
+#endif
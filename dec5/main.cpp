@@ -19,11 +19,15 @@ struct letter_compare {
     }
 };
 
+namespace reference {
+
 void process_str(std::string& str)
 {
+    AOC_SCOPED_TIMER("process_str");
     auto iter = str.begin();
 
     while (iter != str.end()) {
+        AOC_COUNT("process_str iterations", 1);
         const auto new_iter = nano::adjacent_find(iter, str.end(), letter_compare{});
         if (new_iter == str.end()) {
             break;
@@ -46,39 +50,135 @@ std::string fully_process(std::string str)
 
 }
 
-int main(int argc, char** argv)
+// Reacts the polymer in a single pass: each unit either annihilates the
+// unit on top of the stack of survivors so far, or is pushed onto it. The
+// stack lives in out, which must have room for str.size() units; units of
+// the (lower case) type remove are dropped first, if it's given. Returns the
+// reacted length.
+constexpr size_t react_into(std::string_view str, char remove, char* out)
 {
-    if (argc < 2) {
-        std::cerr << "Give me an input file\n";
-        return -1;
+    size_t len = 0;
+
+    for (const char c : str) {
+        if (remove != '\0' && to_lower(c) == remove) {
+            continue;
+        }
+        if (len > 0 && letter_compare{}(out[len - 1], c)) {
+            --len;
+        } else {
+            out[len++] = c;
+        }
     }
 
-    const std::string original = [&] {
-        std::ifstream in(argv[1]);
-        std::string s;
-        in >> s;
-        return s;
-    }();
+    return len;
+}
 
-    //const std::string original = "dabAcCaCBAcCcaDA";
-    const auto fully_processed = fully_process(original);
-    fmt::print("Part 1: fully processed length: {}\n", fully_processed.size());
+std::string fully_process(std::string_view str)
+{
+    std::string out(str.size(), '\0');
+    out.resize(react_into(str, '\0', out.data()));
+    return out;
+}
 
-    {
-        std::array<int, 26> results{};
+// Both parts without the heap, for solving an input of (at most) N units at
+// compile time
+template <size_t N>
+constexpr size_t reacted_length(std::string_view polymer)
+{
+    std::array<char, N> buf{};
+    return react_into(polymer, '\0', buf.data());
+}
 
-        for (int i = 0; i < 26; i++) {
-            const char remove_c = 'a' + i;
+template <size_t N>
+constexpr size_t shortest_removal(std::string_view polymer)
+{
+    std::array<char, N> reacted{};
+    const size_t len = react_into(polymer, '\0', reacted.data());
+
+    std::array<char, N> buf{};
+    size_t best = len;
+    for (char c = 'a'; c <= 'z'; c++) {
+        const size_t l = react_into({reacted.data(), len}, c, buf.data());
+        best = l < best ? l : best;
+    }
+    return best;
+}
 
-            std::string str = fully_processed;
-            str.erase(nano::remove(str, remove_c, to_lower), str.end());
+static_assert(reacted_length<16>("dabAcCaCBAcCcaDA") == 10);
+static_assert(shortest_removal<16>("dabAcCaCBAcCcaDA") == 4);
 
-            results[i] = fully_process(std::move(str)).size();
-        }
+std::string read_polymer(std::string_view input)
+{
+    const auto polymer = aoc::trim(input);
+    if (polymer.empty()) {
+        aoc::bad_input("no polymer");
+    }
+    if (!nano::all_of(polymer, [](char c) { return is_upper(c) || (c >= 'a' && c <= 'z'); })) {
+        aoc::bad_input("the polymer has units which aren't letters");
+    }
+    return std::string(polymer);
+}
 
-        const auto iter = nano::min_element(results);
+// Returns the shortest length found by removing a single letter from
+// the (already fully processed) polymer, along with that letter
+template <typename Reduce>
+std::pair<int, char> best_removal(const std::string& fully_processed, Reduce reduce)
+{
+    std::array<int, 26> results{};
 
-        fmt::print("Shortest length was {}, found by removing element {}\n",
-                   *iter, (char)('a' + nano::distance(results.begin(), iter)));
-    }
-}
\ No newline at end of file
+    aoc::parallel_for(0, 26, [&](int i) {
+        const char remove_c = 'a' + i;
+
+        std::string str = fully_processed;
+        str.erase(nano::remove(str, remove_c, to_lower), str.end());
+
+        results[i] = reduce(std::move(str)).size();
+    });
+
+    const auto iter = nano::min_element(results);
+
+    return {*iter, (char)('a' + nano::distance(results.begin(), iter))};
+}
+
+template <typename Reduce>
+size_t part_one(const std::string& polymer, Reduce reduce)
+{
+    return reduce(polymer).size();
+}
+
+template <typename Reduce>
+int part_two(const std::string& polymer, Reduce reduce)
+{
+    return best_removal(reduce(polymer), reduce).first;
+}
+
+const auto fast_engine = [](std::string_view str) { return fully_process(str); };
+const auto reference_engine = [](std::string str) { return reference::fully_process(std::move(str)); };
+
+const bool registered = aoc::register_day(5, "dec5", read_polymer,
+    [](const std::string& polymer) { return part_one(polymer, fast_engine); },
+    [](const std::string& polymer) { return part_two(polymer, fast_engine); });
+
+const bool registered_reference = aoc::register_reference(5, "dec5", read_polymer,
+    [](const std::string& polymer) { return part_one(polymer, reference_engine); },
+    [](const std::string& polymer) { return part_two(polymer, reference_engine); });
+
+}
+
+#ifndef AOC_NO_MAIN
+#ifdef AOC_EMBED_INPUT
+int main()
+{
+    constexpr auto polymer = aoc::trim(aoc::embedded_input);
+    constexpr size_t pt1 = reacted_length<polymer.size()>(polymer);
+    fmt::print("Part one: {}\n", pt1);
+    constexpr size_t pt2 = shortest_removal<polymer.size()>(polymer);
+    fmt::print("Part two: {}\n", pt2);
+}
+#else
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, 5);
+}
+#endif
+#endif
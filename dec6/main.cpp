@@ -55,15 +55,25 @@ boundary calculate_boundary(const Points& pts)
     return {min_x.x, max_x.x, min_y.y, max_y.y};
 }
 
-std::vector<point> read_points(std::istream& is)
+std::vector<point> read_points(std::string_view input)
 {
     std::vector<point> v;
-    std::string s;
-    while(std::getline(is, s)) {
+    constexpr aoc::pattern point_pattern{"{}, {}"};
+    for (const auto line : aoc::lines(input)) {
         point p;
-        std::sscanf(s.c_str(), "%d, %d", &p.x, &p.y);
+        point_pattern.scan_or_throw(line, p.x, p.y);
         v.push_back(std::move(p));
     }
+
+    if (v.empty()) {
+        aoc::bad_input("no coordinates");
+    }
+    // Both parts go over every location in the bounding box
+    constexpr int64_t max_area = int64_t{1} << 30;
+    const auto b = calculate_boundary(v);
+    if ((int64_t{b.max_x} - b.min_x + 1) * (int64_t{b.max_y} - b.min_y + 1) > max_area) {
+        aoc::bad_input("the coordinates are too far apart");
+    }
     return v;
 }
 
@@ -76,86 +86,82 @@ const std::array<point, 6> test_coords = {
     { 8, 9 }
 };
 
-}
-
-int main(int argc, char** argv)
+template <typename Points>
+int part_one(const Points& points)
 {
-#if 1
-    if (argc < 2) {
-        std::cerr << "I require some input\n";
-        return -1;
-    }
-
-    std::fstream file(argv[1]);
-    const auto points = read_points(file);
-
-    constexpr int distance_limit = 10'000;
-
-#else
-    const auto& points = test_coords;
-    constexpr int distance_limit = 32;
-#endif
-
     // Works out the boundaries
     const auto b = calculate_boundary(points);
 
-    // Part 1
+    // For each point p inside the boundary, find the index of its nearest
+    // point, or -1 if there's a tie. Columns are done in parallel.
+    const int width = b.max_x - b.min_x + 1;
+    const int height = b.max_y - b.min_y + 1;
+    aoc::grid<int> nearest(width, height);
 
-    // For each point p inside the boundary, find its nearest point.
-    auto nearest_area = std::vector<int>(nano::size(points));
+    aoc::parallel_for(0, width, [&](int i) {
+        for (int j = 0; j < height; ++j) {
+            const auto opt = find_unique_nearest(point{b.min_x + i, b.min_y + j}, points);
+            nearest(i, j) = opt ? nano::distance(nano::begin(points), *opt) : -1;
+        }
+    });
 
-    for (auto i = b.min_x; i <= b.max_x; ++i) {
-        for (auto j = b.min_y; j <= b.max_y; ++j) {
-            const auto opt = find_unique_nearest(point{i, j}, points);
-            if (opt) {
-                const auto idx = nano::distance(nano::begin(points), *opt);
-                ++nearest_area[idx];
-            }
+    auto nearest_area = std::vector<int>(nano::size(points));
+    nearest.for_each([&](int, int, int idx) {
+        if (idx >= 0) {
+            ++nearest_area[idx];
         }
-    }
+    });
 
     // We now need to discount all those points which have "infinite" area
     // Basically, a point has "infinite area" if one of the boundary points is
     // closest to it.
-    // We'll go through and "fix" this by running over all found boundary edges
-    // and setting nearsest_area[i] to zero
-    for (auto i = b.min_x; i <= b.max_x; ++i) {
-        const auto o1 = find_unique_nearest(point{i, b.min_y}, points);
-        const auto o2 = find_unique_nearest(point{i, b.max_y}, points);
-        if (o1) nearest_area[*o1 - points.begin()] = 0;
-        if (o2) nearest_area[*o2 - points.begin()] = 0;
-    }
-
-    for (auto j = b.min_y; j <= b.max_y; j++) {
-        const auto o1 = find_unique_nearest(point{b.min_x, j}, points);
-        const auto o2 = find_unique_nearest(point{b.max_x, j}, points);
-        if (o1) nearest_area[*o1 - points.begin()] = 0;
-        if (o2) nearest_area[*o2 - points.begin()] = 0;
-    }
-
+    // We'll go through and "fix" this by running over all four boundary edges
+    // and setting nearest_area[i] to zero
+    const auto discount = [&](int, int, int idx) {
+        if (idx >= 0) {
+            nearest_area[idx] = 0;
+        }
+    };
+    nearest.for_each_in({0, 0, width, 1}, discount);
+    nearest.for_each_in({0, height - 1, width, 1}, discount);
+    nearest.for_each_in({0, 0, 1, height}, discount);
+    nearest.for_each_in({width - 1, 0, 1, height}, discount);
 
-    std::cout << "Largest was " << nano::max(nearest_area) << '\n';
+    return nano::max(nearest_area);
+}
 
+template <typename Points>
+int part_two(const Points& points, const int distance_limit = 10'000)
+{
+    const auto b = calculate_boundary(points);
 
-    // Part 2
-    {
-        // For each internal point, calculate the distance to each given point, and then
-        // sum those distances. Easy!
+    // For each internal point, calculate the distance to each given point, and then
+    // sum those distances. Easy! (Columns are done in parallel.)
+    return aoc::parallel_reduce(b.min_x, b.max_x + 1, 0, std::plus<>{}, [&](int i) {
         int points_in_region = 0;
-
-        for (auto i = b.min_x; i <= b.max_x; ++i) {
-            for (auto j = b.min_y; j <= b.max_y; ++j) {
-                const point test_point{i, j};
-                const int total_dist = std::accumulate(points.begin(), points.end(), 0,
-                                                       [&](int total, const point& p) {
-                                                           return total + mh_distance(p, test_point);
-                                                       });
-                if (total_dist < distance_limit) {
-                    ++points_in_region;
-                }
+        for (auto j = b.min_y; j <= b.max_y; ++j) {
+            const point test_point{i, j};
+            const int total_dist = std::accumulate(points.begin(), points.end(), 0,
+                                                   [&](int total, const point& p) {
+                                                       return total + mh_distance(p, test_point);
+                                                   });
+            if (total_dist < distance_limit) {
+                ++points_in_region;
             }
         }
+        return points_in_region;
+    });
+}
 
-        std::cout << "The size of the region is " << points_in_region << '\n';
-    }
-}
\ No newline at end of file
+const bool registered = aoc::register_day(6, "dec6", read_points,
+                                          part_one<std::vector<point>>,
+                                          [](const std::vector<point>& p) { return part_two(p); });
+
+}
+
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
+{
+    return aoc::run_main(argc, argv, 6);
+}
+#endif
@@ -5,25 +5,55 @@
 
 namespace {
 
-using steps_map = std::map<char, std::string>;
+using steps_map = std::pmr::map<char, std::pmr::string>;
 
-steps_map parse_steps(std::istream& is)
+// Throws unless every step can be done eventually: with a cycle in the
+// prerequisites, part one would run out of steps to take and part two's
+// workers would wait forever
+void check_no_cycles(const steps_map& steps)
 {
-    std::string s;
+    std::string done;
+    while (done.size() < steps.size()) {
+        const auto ready = nano::find_if(steps, [&done](const auto& kv) {
+            return done.find(kv.first) == std::string::npos &&
+                   nano::all_of(kv.second, [&done](char c) { return done.find(c) != std::string::npos; });
+        });
+        if (ready == steps.end()) {
+            aoc::bad_input("the steps' prerequisites form a cycle");
+        }
+        done += ready->first;
+    }
+}
+
+steps_map parse_steps(std::string_view input)
+{
+    constexpr aoc::pattern step_pattern{"Step {} must be finished before step {} can begin."};
     steps_map out;
 
-    while (std::getline(is, s)) {
-        char prereq = s[5];
-        char step = s[36];
+    for (const auto s : aoc::lines(input)) {
+        char prereq = 0;
+        char step = 0;
+        step_pattern.scan_or_throw(s, prereq, step);
+        const auto is_step = [](char c) { return c >= 'A' && c <= 'Z'; };
+        if (!is_step(prereq) || !is_step(step)) {
+            aoc::bad_input(fmt::format("'{}' names a step which isn't a capital letter", s));
+        }
         out[prereq] += ""; // HACKHACKHACK
         out[step] += prereq;
     }
 
+    if (out.empty()) {
+        aoc::bad_input("no steps");
+    }
+    check_no_cycles(out);
     return out;
 }
 
-std::string part_one(steps_map map)
+std::string part_one(const steps_map& steps)
 {
+    // Work on a copy in an arena, which can be freed in one go at the end
+    aoc::arena arena;
+    steps_map map(steps, &arena);
     std::string output{};
 
     while (!map.empty()) {
@@ -57,34 +87,48 @@ using std::chrono::seconds;
 using namespace std::chrono_literals;
 
 struct worker_pool {
-    worker_pool(const steps_map& smap, int num_workers, seconds time_offset = 0s)
+    worker_pool(const steps_map& smap, int num_workers, seconds time_offset = 0s,
+                std::pmr::memory_resource* mem = std::pmr::get_default_resource())
         : workers(num_workers),
-          map(smap),
+          map(smap, mem),
           time_offset(time_offset)
     {
+        // Show the simulated schedule in the trace, if there is one
+        if (auto& tracer = aoc::instr::tracer::get(); tracer.enabled()) {
+            static std::atomic<int> run{0};
+            timeline = tracer.add_timeline(fmt::format("dec7 simulated workers (run {})", run++));
+        }
+
         enqueue_tasks();
         assign_workers();
     }
 
     void process_second()
     {
+        AOC_COUNT("process_second ticks", 1);
         bool any_finished = false;
 
         for (auto& w : workers) {
             if (!w.is_idle() && --w.time_remaining <= 0s) {
                 auto t = w.current;
+                if (timeline >= 0) {
+                    aoc::instr::tracer::get().add_event(
+                        timeline, fmt::format("worker {}", &w - workers.data()),
+                        fmt::format("step {}", char(t)), w.started, seconds_counter + 1s - w.started);
+                }
                 w.current = worker::idle;
                 any_finished = true;
                 finished_task(t);
             }
         }
 
+        // Tasks assigned now start in the next second
+        ++seconds_counter;
+
         if (any_finished) {
             enqueue_tasks();
             assign_workers();
         }
-
-        ++seconds_counter;
     }
 
     bool done() const
@@ -97,10 +141,12 @@ struct worker_pool {
 private:
     void enqueue_tasks()
     {
-        for (auto& [step, prereqs] : map) {
-            if (prereqs.empty()) {
-                queue.push_back(task{step});
-                map.erase(step);
+        for (auto iter = map.begin(); iter != map.end(); ) {
+            if (iter->second.empty()) {
+                queue.push_back(task{iter->first});
+                iter = map.erase(iter);
+            } else {
+                ++iter;
             }
         }
     }
@@ -134,8 +180,11 @@ private:
         // Assign to first idle worker, if any
         for (auto& w : workers) {
             if (w.is_idle()) {
+#ifdef VERBOSE
                 fmt::print("{}: assigning task {} to worker {}\n", seconds_counter.count(), (char) t, (int) w.id);
+#endif
                 w.current = t;
+                w.started = seconds_counter;
                 w.time_remaining = time_offset + seconds{char(t) - 'A'} + 1s;
                 return true;
             }
@@ -146,11 +195,12 @@ private:
     }
 
     struct worker {
-        inline static int next_id = 0;
+        inline static std::atomic<int> next_id{0};
         static constexpr task idle{'.'};
 
         worker_id id{next_id++};
         task current = idle;
+        seconds started{0};
         seconds time_remaining{0};
 
         bool is_idle() const { return current == idle; }
@@ -161,13 +211,15 @@ private:
     steps_map map;
     seconds time_offset{0};
     seconds seconds_counter{0};
+    int timeline = -1;
 };
 
 
 
 seconds part_two(const steps_map& steps, int num_workers, seconds time_offset)
 {
-    worker_pool pool(steps, num_workers, time_offset);
+    aoc::arena arena;
+    worker_pool pool(steps, num_workers, time_offset, &arena);
 
     while (!pool.done()) {
         pool.process_second();
@@ -185,29 +237,15 @@ Step B must be finished before step E can begin.
 Step D must be finished before step E can begin.
 Step F must be finished before step E can begin.)";
 
+const bool registered = aoc::register_day(7, "dec7", parse_steps, part_one, [](const steps_map& map) {
+    return part_two(map, 5, 60s).count();
+});
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
-#if 1
-    if (argc < 2) {
-        std::cerr << "input please\n";
-        return -1;
-    }
-
-    std::fstream is(argv[1]);
-
-    constexpr int num_workers = 5;
-    constexpr auto time_offset = 60s;
-#else
-    std::istringstream is(test_instructions);
-    constexpr int num_workers = 2;
-    constexpr auto time_offset = 0s;
-#endif
-
-    const auto map = parse_steps(is);
-
-    std::cout << "Part one solution: " << part_one(map) << '\n';
-    int pt2 = part_two(map, num_workers, time_offset).count();
-    std::cout << "Part two took " << pt2 << " seconds\n";
+    return aoc::run_main(argc, argv, 7);
 }
+#endif
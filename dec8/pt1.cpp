@@ -1,9 +1,6 @@
 
-#include <fstream>
-#include <iostream>
-#include <iterator>
-#include <sstream>
-#include <vector>
+#include "../common.hpp"
+#include "tree.hpp"
 
 namespace {
 
@@ -38,24 +35,20 @@ int sum_metadata(Iter first, Iter last)
     return meta_total;
 }
 
+int part_one(const std::vector<int>& ints)
+{
+    return sum_metadata(ints.begin(), ints.end());
+}
+
 constexpr auto& test_data = "2 3 0 3 10 11 12 1 1 0 1 99 2 1 1 2";
 
+const bool registered = aoc::register_day(8, "dec8/pt1", dec8::read_ints, part_one, nullptr);
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
-#if 1
-    if (argc < 2) {
-        std::cerr << "Feed me data!\n";
-        return -1;
-    }
-
-    std::ifstream is(argv[1]);
-#else
-    std::istringstream is(test_data);
-#endif
-
-    std::cout << "Got " << sum_metadata(std::istream_iterator<int>(is), std::istream_iterator<int>{}) << std::endl;
+    return aoc::run_main(argc, argv, 8);
 }
-
-
+#endif
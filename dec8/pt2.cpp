@@ -1,11 +1,20 @@
 
 #include "../common.hpp"
+#include "tree.hpp"
 
 namespace {
 
+// Nodes live in an arena, and are all freed together when it goes away
 struct node {
-    std::vector<std::unique_ptr<node>> children;
-    std::vector<int> metadata;
+    using allocator_type = std::pmr::polymorphic_allocator<node>;
+
+    explicit node(const allocator_type& alloc)
+        : children(alloc),
+          metadata(alloc)
+    {}
+
+    std::pmr::vector<const node*> children;
+    std::pmr::vector<int> metadata;
 
     int get_value() const
     {
@@ -26,51 +35,41 @@ struct node {
 };
 
 template <typename Iter>
-std::unique_ptr<node> make_node(Iter& iter)
+const node& make_node(Iter& iter, aoc::arena& arena)
 {
     const int num_children = *iter++;
     const int num_metas = *iter++;
 
-    auto ptr = std::make_unique<node>();
+    auto& n = arena.make<node>();
 
+    n.children.reserve(num_children);
     for (int i = 0; i < num_children; i++) {
-        ptr->children.push_back(make_node(iter));
+        n.children.push_back(&make_node(iter, arena));
     }
 
-    iter = nano::copy_n(iter, num_metas, nano::back_inserter(ptr->metadata)).in;
+    n.metadata.reserve(num_metas);
+    iter = nano::copy_n(iter, num_metas, nano::back_inserter(n.metadata)).in;
 
-    return ptr;
+    return n;
 }
 
-int get_total_values(std::istream& is)
+int part_two(const std::vector<int>& ints)
 {
-    auto iter = nano::istream_iterator<int>(is);
-    const auto head = make_node(iter);
-
-    return head->get_value();
+    aoc::arena arena;
+    auto iter = ints.begin();
+    const auto& root = make_node(iter, arena);
+    return root.get_value();
 }
 
 constexpr auto& test_data = "2 3 0 3 10 11 12 1 1 0 1 99 2 1 1 2";
 
+const bool registered = aoc::register_day(8, "dec8/pt2", dec8::read_ints, nullptr, part_two);
+
 }
 
+#ifndef AOC_NO_MAIN
 int main(int argc, char** argv)
 {
-#if 1
-    if (argc < 2) {
-        std::cerr << "Feed me data!\n";
-        return -1;
-    }
-
-    std::ifstream is(argv[1]);
-#else
-    std::istringstream is(test_data);
-#endif
-
-    auto iter = nano::istream_iterator<int>(is);
-    const auto root = make_node(iter);
-
-    fmt::print("Root node has value {}\n", root->get_value());
+    return aoc::run_main(argc, argv, 8);
 }
-
-
+#endif
@@ -0,0 +1,72 @@
+#ifndef ADVENT_OF_CODE_2018_DEC8_TREE_HPP
+#define ADVENT_OF_CODE_2018_DEC8_TREE_HPP
+
+#include "../common.hpp"
+
+// The input parsing shared by both parts of day 8
+namespace dec8 {
+
+// Throws unless the numbers are exactly one tree of nodes (each a header
+// giving its numbers of children and metadata entries, then the children,
+// then the metadata), so that the solvers never read past the end. The
+// solvers recurse, so the tree mustn't be too deep either.
+inline void check_tree(const std::vector<int>& ints)
+{
+    constexpr size_t max_depth = 10'000;
+    struct pending {
+        int children;
+        int metadata;
+    };
+    std::vector<pending> stack;
+    size_t pos = 0;
+
+    const auto read_header = [&] {
+        if (ints.size() - pos < 2) {
+            aoc::bad_input("a node's header is cut short");
+        }
+        if (stack.size() == max_depth) {
+            aoc::bad_input("the tree is too deep");
+        }
+        stack.push_back({ints[pos], ints[pos + 1]});
+        pos += 2;
+    };
+
+    read_header();
+    while (!stack.empty()) {
+        if (stack.back().children > 0) {
+            --stack.back().children;
+            read_header();
+            continue;
+        }
+        if (ints.size() - pos < size_t(stack.back().metadata)) {
+            aoc::bad_input("a node's metadata is cut short");
+        }
+        pos += stack.back().metadata;
+        stack.pop_back();
+    }
+
+    if (pos != ints.size()) {
+        aoc::bad_input("there is more than one root node");
+    }
+}
+
+inline std::vector<int> read_ints(std::string_view input)
+{
+    std::vector<int> out;
+    for (const auto word : aoc::words(input)) {
+        const auto i = aoc::try_parse_int(word);
+        if (!i || *i < 0) {
+            aoc::bad_input(fmt::format("'{}' is not a count or metadata entry", word));
+        }
+        out.push_back(*i);
+    }
+    if (out.empty()) {
+        aoc::bad_input("no nodes");
+    }
+    check_tree(out);
+    return out;
+}
+
+} // namespace dec8
+
+#endif
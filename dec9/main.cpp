@@ -1,10 +1,13 @@
 
 #include "../common.hpp"
 
+#include <limits>
 #include <list>
 
 namespace {
 
+namespace reference {
+
 template <typename Iter, typename Cont>
 Iter next_circ(Iter it, Cont& cont, int dist = 1)
 {
@@ -28,7 +31,9 @@ Iter next_circ(Iter it, Cont& cont, int dist = 1)
 int64_t calculate_score(int num_players, int num_marbles)
 {
     std::vector<int64_t> scores(num_players);
-    std::list<int> marbles{0};
+    // Marbles are never freed individually: the whole list goes with the arena
+    aoc::arena arena;
+    auto& marbles = arena.make<std::pmr::list<int>>(std::initializer_list<int>{0});
     auto cur = marbles.begin();
     int current_player = 0;
     auto advance_player = [&] { if (++current_player == num_players) current_player = 0; };
@@ -50,6 +55,79 @@ int64_t calculate_score(int num_players, int num_marbles)
     return nano::max(scores);
 }
 
+}
+
+// As reference::calculate_score(), but with the circle held as a ring of
+// indices: next[m] and prev[m] are the neighbours of marble m, so there is
+// no per-marble allocation and no walking off the end of a list
+int64_t calculate_score(int num_players, int num_marbles)
+{
+    std::vector<int64_t> scores(num_players);
+    aoc::large_vector<int> next(num_marbles + 1);
+    aoc::large_vector<int> prev(num_marbles + 1);
+    int cur = 0;
+    int current_player = 0;
+
+    for (int i = 1; i <= num_marbles; i++)  {
+        if (i % 23 == 0) {
+            for (int n = 0; n < 7; n++) {
+                cur = prev[cur];
+            }
+            scores[current_player] += cur + i;
+            next[prev[cur]] = next[cur];
+            prev[next[cur]] = prev[cur];
+            cur = next[cur];
+        } else {
+            const int before = next[cur];
+            const int after = next[before];
+            next[before] = i;
+            prev[i] = before;
+            next[i] = after;
+            prev[after] = i;
+            cur = i;
+        }
+        if (++current_player == num_players) {
+            current_player = 0;
+        }
+    }
+
+    return nano::max(scores);
+}
+
+struct game {
+    int num_players = 0;
+    int num_marbles = 0;
+};
+
+game read_game(std::string_view input)
+{
+    constexpr aoc::pattern game_pattern{"{} players; last marble is worth {} points"};
+    input = aoc::trim(input);
+    if (input.empty()) {
+        aoc::bad_input("no puzzle input");
+    }
+    game g;
+    game_pattern.scan_or_throw(input, g.num_players, g.num_marbles);
+    if (g.num_players < 1) {
+        aoc::bad_input("there are no players");
+    }
+    // Part two plays a hundred times as many marbles
+    if (g.num_marbles < 1 || g.num_marbles > std::numeric_limits<int>::max() / 100 - 1) {
+        aoc::bad_input(fmt::format("{} points for the last marble is out of range", g.num_marbles));
+    }
+    return g;
+}
+
+int64_t part_one(const game& g)
+{
+    return calculate_score(g.num_players, g.num_marbles);
+}
+
+int64_t part_two(const game& g)
+{
+    return calculate_score(g.num_players, g.num_marbles * 100);
+}
+
 constexpr struct {
     int num_players;
     int num_marbles;
@@ -63,9 +141,16 @@ constexpr struct {
     {30, 5807, 37305}
 };
 
+const bool registered = aoc::register_day(9, "dec9", read_game, part_one, part_two);
+
+const bool registered_reference = aoc::register_reference(9, "dec9", read_game,
+    [](const game& g) { return reference::calculate_score(g.num_players, g.num_marbles); },
+    [](const game& g) { return reference::calculate_score(g.num_players, g.num_marbles * 100); });
+
 }
 
-int main()
+#ifndef AOC_NO_MAIN
+int main(int argc, char** argv)
 {
 #if 1
     for (const auto& t : test_data) {
@@ -77,8 +162,6 @@ int main()
     }
 #endif
 
-    fmt::print("For {} players and {} marbles, highest score was {}\n",
-               412, 71646, calculate_score(412, 71646));
-    fmt::print("For {} players and {} marbles, highest score was {}\n",
-               412, 71464 * 100, calculate_score(412, 71646 * 100));
-}
\ No newline at end of file
+    return aoc::run_main(argc, argv, 9);
+}
+#endif
@@ -0,0 +1,126 @@
+// Turns an input file into a header defining aoc::embedded_input, for
+// building a day with -DAOC_EMBED_INPUT so that it's solved at compile time.
+// See README.md.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+// Appends c as it should appear inside a string literal. Octal escapes are
+// always written with three digits, so a following digit can't extend them.
+void append_escaped(std::string& out, unsigned char c)
+{
+    switch (c) {
+    case '\\': out += "\\\\"; return;
+    case '"': out += "\\\""; return;
+    case '\t': out += "\\t"; return;
+    case '\r': out += "\\r"; return;
+    case '\n': out += "\\n"; return;
+    }
+
+    if (c >= 0x20 && c < 0x7f) {
+        // Keep "??" from forming a trigraph in older language modes
+        if (c == '?' && !out.empty() && out.back() == '?') {
+            out += "\\?";
+        } else {
+            out += char(c);
+        }
+        return;
+    }
+
+    char buf[5];
+    std::snprintf(buf, sizeof(buf), "\\%03o", c);
+    out += buf;
+}
+
+std::string to_header(const std::string& contents)
+{
+    std::string out =
+        "// Generated by embed/main.cpp -- do not edit\n"
+        "#pragma once\n"
+        "\n"
+        "#include <string_view>\n"
+        "\n"
+        "namespace aoc {\n"
+        "\n"
+        "inline constexpr std::string_view embedded_input{\n";
+
+    // One literal per input line, which the compiler concatenates. The size
+    // is given explicitly so that any NULs in the input are kept.
+    bool line_start = true;
+    for (const char c : contents) {
+        if (line_start) {
+            out += "    \"";
+            line_start = false;
+        }
+        append_escaped(out, static_cast<unsigned char>(c));
+        if (c == '\n') {
+            out += "\"\n";
+            line_start = true;
+        }
+    }
+    if (contents.empty()) {
+        out += "    \"\"\n";
+    } else if (!line_start) {
+        out += "\"\n";
+    }
+
+    out += "    , " + std::to_string(contents.size()) + "};\n"
+           "\n"
+           "}\n";
+    return out;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const char* in_path = nullptr;
+    const char* out_path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (!in_path) {
+            in_path = argv[i];
+        } else {
+            std::fprintf(stderr, "Unexpected argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!in_path) {
+        std::fprintf(stderr, "Usage: %s <input> [-o header]\n", argv[0]);
+        return 1;
+    }
+
+    FILE* in = std::fopen(in_path, "rb");
+    if (!in) {
+        std::fprintf(stderr, "Could not open '%s' for reading\n", in_path);
+        return 2;
+    }
+    std::string contents;
+    char buf[4096];
+    while (const size_t n = std::fread(buf, 1, sizeof(buf), in)) {
+        contents.append(buf, n);
+    }
+    std::fclose(in);
+
+    FILE* out = stdout;
+    if (out_path) {
+        out = std::fopen(out_path, "wb");
+        if (!out) {
+            std::fprintf(stderr, "Could not open '%s' for writing\n", out_path);
+            return 2;
+        }
+    }
+
+    const std::string header = to_header(contents);
+    std::fwrite(header.data(), 1, header.size(), out);
+
+    if (out_path) {
+        std::fclose(out);
+    }
+}
@@ -0,0 +1,556 @@
+
+#ifndef ADVENT_OF_CODE_2018_GEN_GENERATORS_HPP
+#define ADVENT_OF_CODE_2018_GEN_GENERATORS_HPP
+
+#include "../common.hpp"
+
+#include <random>
+
+#include "../extern/date.h"
+
+// Generators for synthetic puzzle inputs of arbitrary size.
+//
+// Each generator produces a valid input for its day -- that is, one which
+// the solver can finish on and which has a single right answer -- from a
+// scale and a seed. The same scale and seed always give the same input
+// (we avoid the standard distributions, whose results vary between
+// standard library implementations).
+namespace aoc::gen {
+
+class random {
+public:
+    explicit random(uint64_t seed) : engine_(seed) {}
+
+    // Returns a number in [lo, hi]
+    int64_t uniform(int64_t lo, int64_t hi)
+    {
+        assert(lo <= hi);
+        return lo + static_cast<int64_t>(engine_() % static_cast<uint64_t>(hi - lo + 1));
+    }
+
+    bool coin() { return (engine_() & 1) != 0; }
+
+    template <typename Vec>
+    void shuffle(Vec& vec)
+    {
+        for (size_t i = vec.size(); i > 1; --i) {
+            std::swap(vec[i - 1], vec[uniform(0, i - 1)]);
+        }
+    }
+
+private:
+    std::mt19937_64 engine_;
+};
+
+template <typename... Args>
+void append(std::string& out, const char* fmt_str, const Args&... args)
+{
+    fmt::format_to(std::back_inserter(out), fmt_str, args...);
+}
+
+// Frequency changes which sum to zero, so that part two finishes within
+// two passes over the list
+inline std::string day1(size_t scale, random& rng)
+{
+    std::string out;
+    int64_t total = 0;
+    for (size_t i = 1; i < scale; i++) {
+        const auto change = rng.uniform(1, 100'000) * (rng.coin() ? 1 : -1);
+        total += change;
+        append(out, "{:+}\n", change);
+    }
+    append(out, "{:+}\n", -total);
+    return out;
+}
+
+// Random box ids, plus one pair differing by exactly one character
+inline std::string day2(size_t scale, random& rng)
+{
+    constexpr int len = 26;
+    std::vector<std::string> ids(nano::max(scale, size_t{2}), std::string(len, ' '));
+
+    for (auto& id : ids) {
+        for (char& c : id) {
+            c = 'a' + rng.uniform(0, 25);
+        }
+    }
+
+    const auto first = rng.uniform(0, ids.size() - 2);
+    const auto second = rng.uniform(first + 1, ids.size() - 1);
+    const auto pos = rng.uniform(0, len - 1);
+    ids[second] = ids[first];
+    ids[second][pos] = 'a' + (ids[first][pos] - 'a' + rng.uniform(1, 25)) % 26;
+
+    std::string out;
+    out.reserve(ids.size() * (len + 1));
+    for (const auto& id : ids) {
+        out += id;
+        out += '\n';
+    }
+    return out;
+}
+
+// Claims are generated in overlapping pairs, except for a single claim
+// which is placed off to the side of the rest of the fabric. The fabric
+// grows with the number of claims to keep the density the same as the
+// real puzzle (about 1300 claims on 1000x1000).
+inline std::string day3(size_t scale, random& rng)
+{
+    scale = nano::max(scale, size_t{1});
+    const auto side = static_cast<int64_t>(1000 * std::sqrt(scale / 1300.0)) + 30;
+    const auto lonely = static_cast<size_t>(rng.uniform(0, scale - 1));
+    const auto num_paired = scale - 1;
+
+    std::string out;
+    int64_t left = 0, top = 0, width = 0, height = 0;
+
+    for (size_t i = 0; i < scale; i++) {
+        if (i == lonely) {
+            append(out, "#{} @ {},{}: {}x{}\n", i + 1, side + 1, side + 1,
+                   rng.uniform(1, 29), rng.uniform(1, 29));
+            continue;
+        }
+
+        // An odd number of paired claims means the last one joins the
+        // final pair instead
+        const auto k = i - (i > lonely);
+        if (k % 2 == 0 && (k + 1 < num_paired || k == 0)) {
+            width = rng.uniform(1, 29);
+            height = rng.uniform(1, 29);
+            left = rng.uniform(0, side - width);
+            top = rng.uniform(0, side - height);
+        } else {
+            // Overlap the previous claim
+            left += rng.uniform(0, width - 1);
+            top += rng.uniform(0, height - 1);
+            width = rng.uniform(1, std::min<int64_t>(29, side - left));
+            height = rng.uniform(1, std::min<int64_t>(29, side - top));
+        }
+
+        append(out, "#{} @ {},{}: {}x{}\n", i + 1, left, top, width, height);
+    }
+
+    return out;
+}
+
+// One shift per day, in shuffled order, with up to three naps per shift
+inline std::string day4(size_t scale, random& rng)
+{
+    using namespace std::chrono;
+
+    struct event {
+        date::sys_time<minutes> time;
+        int guard; // 0 for sleep, -1 for wake
+    };
+
+    const auto num_guards = std::max<int64_t>(10, scale / 20);
+    const auto first_day = date::sys_days{date::year{1518}/1/1};
+
+    std::vector<event> events;
+    for (size_t shift = 0; shift < scale; shift++) {
+        const auto midnight = first_day + date::days{shift};
+        const auto start = rng.coin() ? midnight : midnight - minutes{rng.uniform(1, 15)};
+        events.push_back({start, static_cast<int>(rng.uniform(1, num_guards))});
+
+        // The last shift always has a nap, so the log ends with a wake event
+        const auto naps = rng.uniform(shift + 1 == scale ? 1 : 0, 3);
+
+        // Pick distinct minutes for falling asleep and waking up
+        std::array<int, 59> mins{};
+        std::iota(mins.begin(), mins.end(), 1);
+        for (int64_t i = 0; i < naps * 2; i++) {
+            std::swap(mins[i], mins[rng.uniform(i, mins.size() - 1)]);
+        }
+        std::sort(mins.begin(), mins.begin() + naps * 2);
+
+        for (int64_t i = 0; i < naps * 2; i++) {
+            events.push_back({midnight + minutes{mins[i]}, i % 2 == 0 ? 0 : -1});
+        }
+    }
+
+    rng.shuffle(events);
+
+    std::string out;
+    for (const auto& e : events) {
+        const auto day = date::floor<date::days>(e.time);
+        const date::year_month_day ymd{day};
+        const auto mins = (e.time - day).count();
+        append(out, "[{:04}-{:02}-{:02} {:02}:{:02}] ", int(ymd.year()), unsigned(ymd.month()),
+               unsigned(ymd.day()), mins / 60, mins % 60);
+        if (e.guard > 0) {
+            append(out, "Guard #{} begins shift\n", e.guard);
+        } else {
+            out += e.guard == 0 ? "falls asleep\n" : "wakes up\n";
+        }
+    }
+    return out;
+}
+
+inline std::string day5(size_t scale, random& rng)
+{
+    std::string out(scale, ' ');
+    for (char& c : out) {
+        c = (rng.coin() ? 'a' : 'A') + rng.uniform(0, 25);
+    }
+    out += '\n';
+    return out;
+}
+
+// Distinct coordinates, at the same density as the real puzzle
+// (about 50 points in a 360x360 square)
+inline std::string day6(size_t scale, random& rng)
+{
+    const auto side = static_cast<int64_t>(360 * std::sqrt(nano::max(scale, size_t{1}) / 50.0));
+    std::set<std::pair<int64_t, int64_t>> seen;
+
+    std::string out;
+    while (seen.size() < scale) {
+        const auto p = std::pair{rng.uniform(0, side), rng.uniform(0, side)};
+        if (seen.insert(p).second) {
+            append(out, "{}, {}\n", p.first, p.second);
+        }
+    }
+    return out;
+}
+
+// The steps are always the 26 letters, so the scale is the number of
+// dependencies, up to a maximum of 325 (every pair)
+inline std::string day7(size_t scale, random& rng)
+{
+    std::string order = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    rng.shuffle(order);
+
+    std::vector<std::pair<char, char>> edges;
+    for (size_t i = 0; i < order.size(); i++) {
+        for (size_t j = i + 1; j < order.size(); j++) {
+            edges.emplace_back(order[i], order[j]);
+        }
+    }
+    rng.shuffle(edges);
+    edges.resize(nano::min(scale, edges.size()));
+
+    std::string out;
+    for (const auto& [before, after] : edges) {
+        append(out, "Step {} must be finished before step {} can begin.\n", before, after);
+    }
+    return out;
+}
+
+// A tree with the given number of nodes. Children are assigned breadth
+// first, which keeps the tree (and so the solver's recursion) shallow.
+inline std::string day8(size_t scale, random& rng)
+{
+    const size_t num_nodes = nano::max(scale, size_t{1});
+    std::vector<int> num_children(num_nodes);
+    std::vector<size_t> first_child(num_nodes);
+    size_t assigned = 1;
+
+    for (size_t i = 0; i < num_nodes; i++) {
+        // Make sure we don't run out of nodes to expand before we're done
+        const auto min = (i + 1 == assigned && assigned < num_nodes) ? 1 : 0;
+        const auto count = std::min<int64_t>(rng.uniform(min, 4), num_nodes - assigned);
+        num_children[i] = static_cast<int>(count);
+        first_child[i] = assigned;
+        assigned += count;
+    }
+
+    std::vector<int> num_meta(num_nodes);
+    num_meta[0] = static_cast<int>(rng.uniform(1, 3));
+
+    std::string out;
+    append(out, "{} {}", num_children[0], num_meta[0]);
+
+    // Stack of (node, next child to visit)
+    std::vector<std::pair<size_t, int>> stack{{0, 0}};
+
+    while (!stack.empty()) {
+        auto& [node, child] = stack.back();
+        if (child < num_children[node]) {
+            const auto next = first_child[node] + child++;
+            num_meta[next] = static_cast<int>(rng.uniform(1, 3));
+            append(out, " {} {}", num_children[next], num_meta[next]);
+            stack.emplace_back(next, 0);
+        } else {
+            for (int i = 0; i < num_meta[node]; i++) {
+                append(out, " {}", rng.uniform(1, 9));
+            }
+            stack.pop_back();
+        }
+    }
+
+    out += '\n';
+    return out;
+}
+
+inline std::string day9(size_t scale, random& rng)
+{
+    return fmt::format("{} players; last marble is worth {} points\n",
+                       rng.uniform(9, 500), nano::max(scale, size_t{25}));
+}
+
+// Points which converge on a random picture 10 rows high after about
+// ten thousand seconds
+inline std::string day10(size_t scale, random& rng)
+{
+    const auto width = std::max<int64_t>(60, scale / 10);
+    const auto time = rng.uniform(10'000, 11'000);
+
+    std::string out;
+    for (size_t i = 0; i < scale; i++) {
+        // Put a point in each corner, so the picture always has the full size
+        const auto corner = static_cast<int64_t>(i);
+        const auto x = corner < 4 ? (corner % 2) * (width - 1) : rng.uniform(0, width - 1);
+        const auto y = corner < 4 ? (corner / 2) * 9 : rng.uniform(0, 9);
+        int64_t vx = 0, vy = 0;
+        while (vx == 0 && vy == 0) {
+            vx = rng.uniform(-5, 5);
+            vy = rng.uniform(-5, 5);
+        }
+        append(out, "position=<{:6}, {:6}> velocity=<{:2}, {:2}>\n",
+               x - vx * time, y - vy * time, vx, vy);
+    }
+    return out;
+}
+
+// The grid is always 300x300, so there's nothing to scale here
+inline std::string day11(size_t, random& rng)
+{
+    return fmt::format("{}\n", rng.uniform(1, 9999));
+}
+
+// A random initial state, with rules that move every plant one pot to the
+// right each generation. Part two assumes that the pattern eventually
+// settles into a steady state, and most rule sets don't guarantee that.
+inline std::string day12(size_t scale, random& rng)
+{
+    std::string out = "initial state: ";
+    for (size_t i = 0; i < nano::max(scale, size_t{1}); i++) {
+        out += rng.coin() ? '#' : '.';
+    }
+    out += "\n\n";
+
+    for (int pattern = 0; pattern < 32; pattern++) {
+        for (int i = 0; i < 5; i++) {
+            out += (pattern & (1 << i)) ? '#' : '.';
+        }
+        out += (pattern & (1 << 1)) ? " => #\n" : " => .\n";
+    }
+    return out;
+}
+
+// A scale x scale map, made up of separate rectangular loops (one per
+// 16x16 tile) each with two carts heading towards each other, except for
+// one loop which has a single cart. Every other cart eventually crashes.
+// The map is at least two tiles across, so that there is a crash at all.
+inline std::string day13(size_t scale, random& rng)
+{
+    constexpr int64_t tile = 16;
+    const auto side = std::max<int64_t>(scale, 2 * tile);
+    const auto tiles_per_side = side / tile;
+    const auto lonely = rng.uniform(0, tiles_per_side * tiles_per_side - 1);
+
+    std::vector<std::string> rows(side, std::string(side, ' '));
+
+    for (int64_t ty = 0; ty < tiles_per_side; ty++) {
+        for (int64_t tx = 0; tx < tiles_per_side; tx++) {
+            const auto w = rng.uniform(3, tile - 2);
+            const auto h = rng.uniform(2, tile - 2);
+            const auto x0 = tx * tile + rng.uniform(0, tile - 1 - w);
+            const auto y0 = ty * tile + rng.uniform(0, tile - 1 - h);
+            const auto x1 = x0 + w;
+            const auto y1 = y0 + h;
+
+            for (auto x = x0 + 1; x < x1; x++) {
+                rows[y0][x] = '-';
+                rows[y1][x] = '-';
+            }
+            for (auto y = y0 + 1; y < y1; y++) {
+                rows[y][x0] = '|';
+                rows[y][x1] = '|';
+            }
+            rows[y0][x0] = '/';
+            rows[y0][x1] = '\\';
+            rows[y1][x0] = '\\';
+            rows[y1][x1] = '/';
+
+            // Carts go on the top edge
+            const auto c1 = rng.uniform(x0 + 1, x1 - 1);
+            rows[y0][c1] = '>';
+            if (ty * tiles_per_side + tx != lonely) {
+                auto c2 = rng.uniform(x0 + 1, x1 - 2);
+                if (c2 >= c1) {
+                    ++c2;
+                }
+                rows[y0][c2] = '<';
+            }
+        }
+    }
+
+    std::string out;
+    out.reserve(side * (side + 1));
+    for (const auto& row : rows) {
+        out += row;
+        out += '\n';
+    }
+    return out;
+}
+
+// Part two searches for the input's digits on the scoreboard, and not
+// every sequence appears (two zeros in a row are very rare, for example),
+// so we take six digits from about scale recipes in
+inline std::string day14(size_t scale, random& rng)
+{
+    scale = nano::max(scale, size_t{100});
+    std::vector<uint8_t> scores{3, 7};
+    size_t pos1 = 0, pos2 = 1;
+
+    while (scores.size() < scale + 16) {
+        const int sum = scores[pos1] + scores[pos2];
+        if (sum >= 10) {
+            scores.push_back(sum / 10);
+        }
+        scores.push_back(sum % 10);
+        pos1 = (pos1 + 1 + scores[pos1]) % scores.size();
+        pos2 = (pos2 + 1 + scores[pos2]) % scores.size();
+    }
+
+    auto start = static_cast<size_t>(rng.uniform(scale / 2, scale));
+    while (scores[start] == 0) {
+        ++start;
+    }
+
+    std::string out;
+    for (size_t i = start; i < start + 6; i++) {
+        out += static_cast<char>('0' + scores[i]);
+    }
+    out += '\n';
+    return out;
+}
+
+// Samples of a random opcode numbering (enough of them to pin it down),
+// followed by a random test program of the same length
+inline std::string day16(size_t scale, random& rng)
+{
+    using state_t = std::array<uint32_t, 4>;
+    const auto apply = [](int op, state_t reg, uint32_t a, uint32_t b, uint32_t c) {
+        switch (op) {
+        case 0: reg[c] = reg[a] + reg[b]; break;
+        case 1: reg[c] = reg[a] + b; break;
+        case 2: reg[c] = reg[a] * reg[b]; break;
+        case 3: reg[c] = reg[a] * b; break;
+        case 4: reg[c] = reg[a] & reg[b]; break;
+        case 5: reg[c] = reg[a] & b; break;
+        case 6: reg[c] = reg[a] | reg[b]; break;
+        case 7: reg[c] = reg[a] | b; break;
+        case 8: reg[c] = reg[a]; break;
+        case 9: reg[c] = a; break;
+        case 10: reg[c] = a > reg[b]; break;
+        case 11: reg[c] = reg[a] > b; break;
+        case 12: reg[c] = reg[a] > reg[b]; break;
+        case 13: reg[c] = a == reg[b]; break;
+        case 14: reg[c] = reg[a] == b; break;
+        case 15: reg[c] = reg[a] == reg[b]; break;
+        }
+        return reg;
+    };
+
+    std::array<int, 16> numbering{};
+    std::iota(numbering.begin(), numbering.end(), 0);
+    rng.shuffle(numbering);
+
+    // possible[opcode] is a bitmask of the operations it could still be
+    std::array<uint32_t, 16> possible{};
+    possible.fill(0xFFFF);
+    const auto resolved = [&] {
+        auto p = possible;
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (auto& bits : p) {
+                if (__builtin_popcount(bits) == 1) {
+                    for (auto& other : p) {
+                        if (&other != &bits && (other & bits)) {
+                            other &= ~bits;
+                            changed = true;
+                        }
+                    }
+                }
+            }
+        }
+        return nano::all_of(p, [](uint32_t bits) { return __builtin_popcount(bits) == 1; });
+    };
+
+    std::string out;
+    const auto print_state = [&](const char* label, const state_t& s) {
+        append(out, "{}[{}, {}, {}, {}]\n", label, s[0], s[1], s[2], s[3]);
+    };
+
+    for (size_t i = 0; i < scale || !resolved(); i++) {
+        if (i > 0) {
+            out += '\n';
+        }
+        const auto opcode = static_cast<int>(rng.uniform(0, 15));
+        const auto a = rng.uniform(0, 3), b = rng.uniform(0, 3), c = rng.uniform(0, 3);
+        state_t before{};
+        for (auto& r : before) {
+            r = static_cast<uint32_t>(rng.uniform(0, 3));
+        }
+        const auto after = apply(numbering[opcode], before, a, b, c);
+
+        for (int op = 0; op < 16; op++) {
+            if (apply(op, before, a, b, c) != after) {
+                possible[opcode] &= ~(1u << op);
+            }
+        }
+
+        print_state("Before: ", before);
+        append(out, "{} {} {} {}\n", opcode, a, b, c);
+        print_state("After:  ", after);
+    }
+
+    out += "\n\n\n";
+    for (size_t i = 0; i < nano::max(scale, size_t{1}); i++) {
+        append(out, "{} {} {} {}\n", rng.uniform(0, 15), rng.uniform(0, 3),
+               rng.uniform(0, 3), rng.uniform(0, 3));
+    }
+    return out;
+}
+
+struct generator {
+    int day;
+    size_t default_scale;
+    std::string (*generate)(size_t, random&);
+};
+
+inline constexpr std::array<generator, 15> generators = {{
+    {1, 10'000'000, day1},
+    {2, 100'000, day2},
+    {3, 1'000'000, day3},
+    {4, 100'000, day4},
+    {5, 1'000'000, day5},
+    {6, 1'000, day6},
+    {7, 325, day7},
+    {8, 1'000'000, day8},
+    {9, 71'646, day9},
+    {10, 100'000, day10},
+    {11, 1, day11},
+    {12, 100'000, day12},
+    {13, 1'000, day13},
+    {14, 10'000'000, day14},
+    {16, 100'000, day16},
+}};
+
+inline const generator* find_generator(int day)
+{
+    const auto iter = nano::find(generators, day, &generator::day);
+    return iter == generators.end() ? nullptr : &*iter;
+}
+
+inline std::string generate(const generator& g, size_t scale, uint64_t seed)
+{
+    random rng{seed ^ (static_cast<uint64_t>(g.day) << 32)};
+    return g.generate(scale, rng);
+}
+
+}
+
+#endif
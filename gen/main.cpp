@@ -0,0 +1,57 @@
+
+// Writes a synthetic input for the given day to stdout (or a file).
+// See generators.hpp for what each day's scale means.
+
+#include "generators.hpp"
+
+#include <cstdio>
+
+int main(int argc, char** argv)
+{
+    int day = 0;
+    std::optional<size_t> scale;
+    uint64_t seed = 2018;
+    const char* out_path = nullptr;
+
+    constexpr aoc::pattern num{"{}"};
+    bool ok = argc > 1 && num.scan(argv[1], day);
+
+    for (int i = 2; ok && i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--seed" && i + 1 < argc) {
+            ok = num.scan(argv[++i], seed);
+        } else if (arg == "-o" && i + 1 < argc) {
+            out_path = argv[++i];
+        } else if (!scale) {
+            size_t s = 0;
+            ok = num.scan(arg, s);
+            scale = s;
+        } else {
+            ok = false;
+        }
+    }
+
+    const auto* gen = ok ? aoc::gen::find_generator(day) : nullptr;
+    if (!gen) {
+        fmt::print(stderr, "Usage: {} <day> [scale] [--seed N] [-o file]\n", argv[0]);
+        fmt::print(stderr, "Available days (default scale):\n");
+        for (const auto& g : aoc::gen::generators) {
+            fmt::print(stderr, "  {:2} ({})\n", g.day, g.default_scale);
+        }
+        return 1;
+    }
+
+    const auto str = aoc::gen::generate(*gen, scale.value_or(gen->default_scale), seed);
+
+    std::FILE* out = out_path ? std::fopen(out_path, "wb") : stdout;
+    if (!out) {
+        fmt::print(stderr, "Could not open {}\n", out_path);
+        return 2;
+    }
+
+    std::fwrite(str.data(), 1, str.size(), out);
+
+    if (out_path) {
+        std::fclose(out);
+    }
+}
@@ -0,0 +1,330 @@
+// Scaling study: runs every registered day over a geometric sweep of
+// generated input sizes, fits each stage's times to 1, n, n log n, n^2 and n^3
+// and reports the apparent complexity, flagging stages which grow faster
+// than they need to. See README.md in this directory for how to build it.
+
+// This file has its own main() even when the days' are compiled out; see
+// AOC_TRACK_ALLOCS in common.hpp
+#undef AOC_NO_MAIN
+
+#include "../gen/generators.hpp"
+
+#include <cmath>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using duration = std::chrono::duration<double, std::milli>;
+
+struct options {
+    int only_day = 0;
+    int runs = 3;
+    int steps = 7;
+    double factor = 2.0;
+    double budget_ms = 2000.0;
+    double min_ms = 0.5;
+    uint64_t seed = 2018;
+    bool references = false;
+};
+
+// The models we fit, in order of growth
+struct model {
+    const char* name;
+    double (*f)(double);
+};
+
+constexpr std::array<model, 5> models = {{
+    {"1", [](double) { return 1.0; }},
+    {"n", [](double n) { return n; }},
+    {"n log n", [](double n) { return n * std::log2(nano::max(n, 2.0)); }},
+    {"n^2", [](double n) { return n * n; }},
+    {"n^3", [](double n) { return n * n * n; }},
+}};
+
+constexpr size_t n_log_n = 2;
+
+// The growth we expect of a good solver for each day, in terms of the
+// generator's scale, where that's worse than n log n. dec13's scale is the
+// side of the map, so even reading it is quadratic.
+size_t expected_model(const aoc::day_entry& entry)
+{
+    return entry.day == 13 ? n_log_n + 1 : n_log_n;
+}
+
+struct sample {
+    size_t scale = 0;
+    size_t input_bytes = 0;
+    std::array<duration, 3> stages{}; // parse, part one, part two
+};
+
+constexpr std::array<const char*, 3> stage_names = {"parse", "part one", "part two"};
+
+template <typename Func>
+duration time_call(Func&& func)
+{
+    const auto start = clock_type::now();
+    std::forward<Func>(func)();
+    return clock_type::now() - start;
+}
+
+// Runs each stage on the input the given number of times, keeping the
+// fastest time for each
+sample measure(const options& opts, const aoc::day_entry& entry, size_t scale,
+               std::string_view input)
+{
+    sample s;
+    s.scale = scale;
+    s.input_bytes = input.size();
+    s.stages.fill(duration::max());
+
+    for (int run = 0; run < opts.runs; run++) {
+        std::any parsed;
+        const std::array<duration, 3> times = {
+            time_call([&] { parsed = entry.parse(input); }),
+            entry.part_one ? time_call([&] { entry.part_one(parsed); }) : duration{},
+            entry.part_two ? time_call([&] { entry.part_two(parsed); }) : duration{}
+        };
+        for (size_t i = 0; i < times.size(); i++) {
+            s.stages[i] = nano::min(s.stages[i], times[i]);
+        }
+    }
+
+    return s;
+}
+
+struct fit {
+    size_t best = 0;   // index into models
+    double slope = 0;  // of log(time) against log(n)
+    size_t points = 0;
+};
+
+// Fits t = c * f(n) for each model by least squares on the logarithms, so
+// that every point counts the same however long it took, and picks the
+// model with the smallest residual. Points faster than the noise floor are
+// left out, since they mostly measure overhead.
+std::optional<fit> fit_stage(const options& opts, const std::vector<sample>& samples, size_t stage)
+{
+    std::vector<std::pair<double, double>> points; // (log n, log t)
+    for (const auto& s : samples) {
+        if (s.stages[stage].count() >= opts.min_ms) {
+            points.emplace_back(std::log(double(s.scale)), std::log(s.stages[stage].count()));
+        }
+    }
+    if (points.size() < 3) {
+        return std::nullopt;
+    }
+
+    fit result;
+    result.points = points.size();
+
+    double best_rss = std::numeric_limits<double>::infinity();
+    for (size_t m = 0; m < models.size(); m++) {
+        // The best log c is the mean of log t - log f(n)
+        double mean = 0;
+        for (const auto& [ln, lt] : points) {
+            mean += lt - std::log(models[m].f(std::exp(ln)));
+        }
+        mean /= points.size();
+
+        double rss = 0;
+        for (const auto& [ln, lt] : points) {
+            const double r = lt - std::log(models[m].f(std::exp(ln))) - mean;
+            rss += r * r;
+        }
+        if (rss < best_rss) {
+            best_rss = rss;
+            result.best = m;
+        }
+    }
+
+    double mean_x = 0, mean_y = 0;
+    for (const auto& [x, y] : points) {
+        mean_x += x;
+        mean_y += y;
+    }
+    mean_x /= points.size();
+    mean_y /= points.size();
+    double sxy = 0, sxx = 0;
+    for (const auto& [x, y] : points) {
+        sxy += (x - mean_x) * (y - mean_y);
+        sxx += (x - mean_x) * (x - mean_x);
+    }
+    result.slope = sxx > 0 ? sxy / sxx : 0.0;
+
+    return result;
+}
+
+// The scales to try for a day: steps of the given factor, finishing at the
+// generator's default scale
+std::vector<size_t> sweep(const options& opts, const aoc::gen::generator& gen)
+{
+    std::vector<size_t> scales;
+    double s = double(gen.default_scale);
+    for (int i = 0; i < opts.steps && s >= 1.0; i++) {
+        const auto scale = size_t(std::llround(s));
+        if (scales.empty() || scales.back() != scale) {
+            scales.push_back(scale);
+        }
+        s /= opts.factor;
+    }
+    nano::reverse(scales);
+    return scales;
+}
+
+// Sweeps a day and prints its times and fits. Returns the number of stages
+// which grew faster than expected.
+int study_day(const options& opts, const aoc::day_entry& entry, const char* suffix)
+{
+    const auto* gen = aoc::gen::find_generator(entry.day);
+    if (!gen) {
+        fmt::print(stderr, "Skipping {}: no generator for day {}\n", entry.name, entry.day);
+        return 0;
+    }
+
+    fmt::print("{}{}\n", entry.name, suffix);
+    fmt::print("  {:>10} {:>10} {:>11} {:>11} {:>11}\n",
+               "scale", "input", "parse", "part one", "part two");
+
+    std::vector<sample> samples;
+    std::string last_input;
+    for (const size_t scale : sweep(opts, *gen)) {
+        // Some generators stop growing at a cap (dec7) or don't scale at all
+        // (dec11), and repeating the same input tells us nothing
+        auto input = aoc::gen::generate(*gen, scale, opts.seed);
+        if (input == last_input) {
+            continue;
+        }
+
+        const auto s = measure(opts, entry, scale, input);
+        fmt::print("  {:>10} {:>10} {:>11.3f} {:>11.3f} {:>11.3f}\n", s.scale, s.input_bytes,
+                   s.stages[0].count(), s.stages[1].count(), s.stages[2].count());
+        std::fflush(stdout);
+        samples.push_back(s);
+        last_input = std::move(input);
+
+        // Going bigger again could take many times longer
+        if (nano::any_of(s.stages, [&](duration d) { return d.count() > opts.budget_ms; })) {
+            fmt::print("  (stopping: over the {:.0f} ms budget)\n", opts.budget_ms);
+            break;
+        }
+    }
+
+    if (samples.size() < 3) {
+        fmt::print("  fewer than three distinct sizes measured; nothing to fit\n\n");
+        return 0;
+    }
+
+    int flagged = 0;
+    for (size_t stage = 0; stage < stage_names.size(); stage++) {
+        if ((stage == 1 && !entry.part_one) || (stage == 2 && !entry.part_two)) {
+            continue;
+        }
+
+        const auto f = fit_stage(opts, samples, stage);
+        if (!f) {
+            fmt::print("  {:<9} too fast to fit\n", stage_names[stage]);
+            continue;
+        }
+
+        const bool super = f->best > expected_model(entry);
+        fmt::print("  {:<9} ~ {:<8} (slope {:.2f} over {} points){}\n", stage_names[stage],
+                   models[f->best].name, f->slope, f->points,
+                   super ? fmt::format("  SUPER-LINEAR, expected {}",
+                                       models[expected_model(entry)].name) : "");
+        flagged += super;
+    }
+    fmt::print("\n");
+
+    return flagged;
+}
+
+std::optional<options> parse_args(int argc, char** argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        const auto next = [&](auto& out) {
+            return ++i < argc && aoc::pattern{"{}"}.scan(argv[i], out);
+        };
+        // pattern only does integers
+        const auto next_double = [&](double& out) {
+            if (++i >= argc) {
+                return false;
+            }
+            const auto end = argv[i] + std::strlen(argv[i]);
+            const auto [ptr, ec] = std::from_chars(argv[i], end, out);
+            return ec == std::errc{} && ptr == end;
+        };
+
+        if (arg == "--day" || arg == "-d") {
+            if (!next(opts.only_day)) return std::nullopt;
+        } else if (arg == "--runs" || arg == "-n") {
+            if (!next(opts.runs) || opts.runs < 1) return std::nullopt;
+        } else if (arg == "--steps") {
+            if (!next(opts.steps) || opts.steps < 3) return std::nullopt;
+        } else if (arg == "--factor") {
+            if (!next_double(opts.factor) || opts.factor <= 1.0) return std::nullopt;
+        } else if (arg == "--budget") {
+            if (!next_double(opts.budget_ms) || opts.budget_ms <= 0) return std::nullopt;
+        } else if (arg == "--min-time") {
+            if (!next_double(opts.min_ms) || opts.min_ms < 0) return std::nullopt;
+        } else if (arg == "--seed") {
+            if (!next(opts.seed)) return std::nullopt;
+        } else if (arg == "--reference") {
+            opts.references = true;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    return opts;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto opts = parse_args(argc, argv);
+    if (!opts) {
+        fmt::print(stderr, "Usage: {} [--day N] [--runs N] [--steps N] [--factor F]\n"
+                           "           [--budget MS] [--min-time MS] [--seed N] [--reference]\n",
+                   argv[0]);
+        return 1;
+    }
+
+    auto days = aoc::registry();
+    nano::sort(days, nano::less<>{}, [](const auto& e) { return std::tie(e.day, e.name); });
+
+    fmt::print("{} steps of x{} up to each generator's default scale, fastest of {} runs, "
+               "times in ms\n\n", opts->steps, opts->factor, opts->runs);
+
+    int flagged = 0;
+    for (const auto& entry : days) {
+        if (opts->only_day != 0 && entry.day != opts->only_day) {
+            continue;
+        }
+
+        const auto run = [&](const aoc::day_entry& e, const char* suffix) {
+            try {
+                flagged += study_day(*opts, e, suffix);
+            } catch (const std::exception& ex) {
+                fmt::print("  ERROR: {}\n\n", ex.what());
+            }
+        };
+
+        run(entry, "");
+        if (opts->references) {
+            for (const auto& ref : aoc::reference_registry()) {
+                if (ref.name == entry.name) {
+                    run(ref, " (reference)");
+                }
+            }
+        }
+    }
+
+    if (flagged > 0) {
+        fmt::print("{} stage(s) grew faster than expected\n", flagged);
+        return 2;
+    }
+}
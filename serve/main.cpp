@@ -0,0 +1,495 @@
+// Solver server: a single long-running process with every day linked in,
+// which takes (day, input path) jobs on stdin or a Unix domain socket and
+// answers each with one line of JSON. It can also solve a whole batch of
+// inputs for one day concurrently. See README.md in this directory.
+
+// This file has its own main() even when the days' are compiled out; see
+// AOC_TRACK_ALLOCS in common.hpp
+#undef AOC_NO_MAIN
+
+#include "../common.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <filesystem>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+using aoc::json_quote;
+
+using clock_type = std::chrono::steady_clock;
+using duration = std::chrono::duration<double, std::milli>;
+
+struct options {
+    std::string socket_path;
+    int batch_day = 0;
+    std::string batch_source;
+    size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string cache_dir;
+    int timeout_secs = 60;
+};
+
+template <typename Func>
+duration time_call(Func&& func)
+{
+    const auto start = clock_type::now();
+    std::forward<Func>(func)();
+    return clock_type::now() - start;
+}
+
+// Days are given either as a number or a directory name like "dec5"
+std::optional<int> parse_day(std::string_view str)
+{
+    if (str.substr(0, 3) == "dec") {
+        str.remove_prefix(3);
+    }
+
+    int day = 0;
+    if (!aoc::pattern{"{}"}.scan(str, day)) {
+        return std::nullopt;
+    }
+    return day;
+}
+
+// A job line is "<day> <path>", where the path is the rest of the line
+std::optional<std::pair<int, std::string_view>> parse_job(std::string_view line)
+{
+    const auto space = line.find(' ');
+    if (space == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    const auto day = parse_day(line.substr(0, space));
+    const auto path = line.substr(space + 1);
+    if (!day || path.empty()) {
+        return std::nullopt;
+    }
+
+    return std::pair{*day, path};
+}
+
+// Set by --cache
+std::optional<aoc::result_cache> cache;
+
+// Set by --timeout; zero for no limit
+std::chrono::seconds job_timeout{};
+
+std::string no_such_day(int day, const std::string& path)
+{
+    return fmt::format("{{\"day\": {}, \"path\": {}, \"error\": \"no such day\"}}", day, json_quote(path));
+}
+
+// Days whose parts live in separate files (dec2, dec8) have two registry
+// entries; each part comes from whichever entry has it, parsing the input
+// once per entry. With a cache, an entry whose results are found there
+// isn't run at all.
+std::string run_job(int day, const std::string& path, std::string_view input)
+{
+    const auto entries = aoc::find_day(day);
+    if (entries.empty()) {
+        return no_such_day(day, path);
+    }
+
+    // Solvers check this where a bad input could keep them going forever
+    std::optional<aoc::deadline_scope> deadline;
+    if (job_timeout.count() > 0) {
+        deadline.emplace(job_timeout);
+    }
+
+    std::string out = fmt::format("{{\"day\": {}, \"path\": {}", day, json_quote(path));
+    duration total{};
+    size_t num_cached = 0;
+
+    for (const auto* entry : entries) {
+        std::optional<aoc::result_cache::key> key;
+        if (cache) {
+            key.emplace(*entry, input);
+            if (const auto found = cache->find(*key)) {
+                for (const auto& [part, name] : {std::pair{&found->part_one, "part_one"},
+                                                 std::pair{&found->part_two, "part_two"}}) {
+                    if (*part) {
+                        out += fmt::format(", \"{}\": {}", name, json_quote(**part));
+                    }
+                }
+                ++num_cached;
+                continue;
+            }
+        }
+
+        std::any parsed;
+        total += time_call([&] { parsed = entry->parse(input); });
+
+        aoc::result_cache::results results;
+        const auto run_part = [&](const auto& part, const char* name, auto& result) {
+            if (part) {
+                const auto t = time_call([&] { result = part(parsed); });
+                total += t;
+                out += fmt::format(", \"{}\": {}, \"{}_ms\": {:.3f}", name, json_quote(*result), name, t.count());
+            }
+        };
+        run_part(entry->part_one, "part_one", results.part_one);
+        run_part(entry->part_two, "part_two", results.part_two);
+
+        if (cache) {
+            cache->store(*key, results);
+        }
+    }
+
+    if (num_cached == entries.size()) {
+        out += ", \"cached\": true";
+    }
+    return out + fmt::format(", \"total_ms\": {:.3f}}}", total.count());
+}
+
+std::string run_job(int day, const std::string& path)
+{
+    // Look the day up first, so that it's reported rather than a bad path
+    if (aoc::find_day(day).empty()) {
+        return no_such_day(day, path);
+    }
+    const aoc::mapped_file file(path.c_str());
+    return run_job(day, path, file.view());
+}
+
+// As run_job(), but reporting failures as an error reply, which names the
+// input so that a batch's failures can be told apart
+template <typename... Args>
+std::string try_run_job(int day, const std::string& path, const Args&... args)
+{
+    const auto error_reply = [&](std::string_view what) {
+        return fmt::format("{{\"day\": {}, \"path\": {}, \"error\": {}}}", day, json_quote(path), json_quote(what));
+    };
+    try {
+        return run_job(day, path, args...);
+    } catch (const std::exception& e) {
+        return error_reply(e.what());
+    } catch (...) {
+        return error_reply("unknown exception");
+    }
+}
+
+// The parallel solvers already use every core, so jobs from different
+// connections take turns rather than fighting over them
+std::mutex job_mutex;
+
+std::string handle_line(std::string_view line)
+{
+    const auto job = parse_job(line);
+    if (!job) {
+        return fmt::format("{{\"error\": \"expected '<day> <path>'\", \"line\": {}}}", json_quote(line));
+    }
+
+    std::lock_guard lock(job_mutex);
+    return try_run_job(job->first, std::string(job->second));
+}
+
+void serve_stream(std::FILE* in, std::FILE* out)
+{
+    std::string line;
+    int c = 0;
+    while ((c = std::fgetc(in)) != EOF) {
+        if (c != '\n') {
+            line += static_cast<char>(c);
+            continue;
+        }
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            fmt::print(out, "{}\n", handle_line(line));
+            std::fflush(out);
+        }
+        line.clear();
+    }
+}
+
+int serve_socket(const std::string& path)
+{
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (fd < 0 || path.size() >= sizeof(addr.sun_path)) {
+        fmt::print(stderr, "Could not create socket '{}'\n", path);
+        return 1;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+    ::unlink(path.c_str());
+
+    // A client going away mid-reply shouldn't take the server with it
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (::bind(fd, reinterpret_cast<const ::sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 16) != 0) {
+        fmt::print(stderr, "Could not listen on '{}': {}\n", path, std::strerror(errno));
+        return 1;
+    }
+
+    while (true) {
+        const int conn = ::accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fmt::print(stderr, "accept() failed: {}\n", std::strerror(errno));
+            return 1;
+        }
+
+        // Each connection gets a thread, so that an idle client can't
+        // hold up the others
+        std::thread([conn] {
+            std::FILE* in = ::fdopen(conn, "r");
+            std::FILE* out = ::fdopen(::dup(conn), "w");
+            if (in && out) {
+                serve_stream(in, out);
+            }
+            if (in) std::fclose(in); else ::close(conn);
+            if (out) std::fclose(out);
+        }).detach();
+    }
+}
+
+// The inputs for a batch: every regular file in a directory, in name
+// order, or else each line of a manifest file
+std::vector<std::string> batch_inputs(const std::string& source)
+{
+    namespace fs = std::filesystem;
+    std::vector<std::string> paths;
+
+    if (fs::is_directory(source)) {
+        for (const auto& entry : fs::directory_iterator(source)) {
+            if (entry.is_regular_file()) {
+                paths.push_back(entry.path().string());
+            }
+        }
+        nano::sort(paths);
+    } else {
+        const aoc::mapped_file manifest(source.c_str());
+        for (const auto line : aoc::lines(manifest.view())) {
+            if (!line.empty()) {
+                paths.emplace_back(line);
+            }
+        }
+    }
+
+    return paths;
+}
+
+// Writes "done/total" to stderr: over and over on one line on a terminal,
+// and otherwise at most once a second, so logs don't fill up
+class progress_reporter {
+public:
+    explicit progress_reporter(size_t total)
+        : total_(total),
+          tty_(::isatty(STDERR_FILENO)),
+          start_(clock_type::now()),
+          last_(start_)
+    {}
+
+    void update(size_t done)
+    {
+        const auto now = clock_type::now();
+        const bool finished = done == total_;
+        if (!finished && now - last_ < (tty_ ? std::chrono::milliseconds(100) : std::chrono::seconds(1))) {
+            return;
+        }
+        last_ = now;
+
+        const auto secs = std::chrono::duration<double>(now - start_).count();
+        fmt::print(stderr, "{}{}/{} inputs, {:.1f}s, {:.1f}/s{}", tty_ ? "\r" : "",
+                   done, total_, secs, secs > 0 ? done / secs : 0.0,
+                   tty_ && !finished ? "" : "\n");
+    }
+
+private:
+    size_t total_;
+    bool tty_;
+    clock_type::time_point start_;
+    clock_type::time_point last_;
+};
+
+// Solves each input on a pool of jobs threads, writing the replies to stdout
+// in the same order as the inputs. The inputs are read ahead by
+// aoc::read_files(), with many reads in flight at once, and handed to the
+// threads in whatever order they arrive. No more than a few inputs past the
+// oldest unwritten reply are read or solved, so one slow input can't leave
+// finished replies (and their memory) piling up behind it.
+int run_batch(const options& opts)
+{
+    std::vector<std::string> paths;
+    try {
+        paths = batch_inputs(opts.batch_source);
+    } catch (const std::exception& e) {
+        fmt::print(stderr, "{}\n", e.what());
+        return 1;
+    }
+
+    const size_t num_threads = std::min(opts.jobs, paths.size());
+    const size_t window = 4 * num_threads;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<aoc::file_read> ready;
+    std::vector<std::optional<std::string>> replies(paths.size());
+    size_t num_read = 0;
+    size_t next_output = 0;
+
+    // Reads stop a window ahead of the output, except that the input the
+    // output is waiting for may still be behind others in the stream, which
+    // has to be drained until it turns up
+    std::vector<bool> arrived(paths.size());
+    std::thread reader([&] {
+        try {
+            for (auto& file : aoc::read_files(paths, window)) {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&] {
+                    return num_read < next_output + window || !arrived[next_output];
+                });
+                ++num_read;
+                arrived[file.index] = true;
+                ready.push_back(std::move(file));
+                cv.notify_all();
+            }
+        } catch (const std::exception& e) {
+            // Whatever wasn't read gets the error as its reply
+            std::lock_guard lock(mutex);
+            for (auto& reply : replies) {
+                if (!reply) {
+                    reply = fmt::format("{{\"day\": {}, \"error\": {}}}", opts.batch_day, json_quote(e.what()));
+                }
+            }
+            ready.clear();
+            num_read = paths.size();
+            cv.notify_all();
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&] {
+            std::unique_lock lock(mutex);
+            while (true) {
+                cv.wait(lock, [&] { return !ready.empty() || num_read == paths.size(); });
+                if (ready.empty()) {
+                    return;
+                }
+                auto file = std::move(ready.front());
+                ready.pop_front();
+
+                lock.unlock();
+                auto reply = file.error.empty()
+                    ? try_run_job(opts.batch_day, file.path, std::string_view(file.contents))
+                    : fmt::format("{{\"day\": {}, \"path\": {}, \"error\": {}}}",
+                                  opts.batch_day, json_quote(file.path), json_quote(file.error));
+                file.contents = {};
+                lock.lock();
+
+                if (!replies[file.index]) {
+                    replies[file.index] = std::move(reply);
+                }
+                cv.notify_all();
+            }
+        });
+    }
+
+    progress_reporter progress(paths.size());
+    {
+        std::unique_lock lock(mutex);
+        while (next_output < paths.size()) {
+            cv.wait(lock, [&] { return replies[next_output].has_value(); });
+            const auto reply = std::move(*replies[next_output]);
+            replies[next_output].reset();
+            const size_t done = ++next_output;
+            cv.notify_all();
+
+            lock.unlock();
+            fmt::print("{}\n", reply);
+            progress.update(done);
+            lock.lock();
+        }
+    }
+
+    reader.join();
+    for (auto& t : threads) {
+        t.join();
+    }
+    return 0;
+}
+
+std::optional<options> parse_args(int argc, char** argv)
+{
+    options opts;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if ((arg == "--socket" || arg == "-s") && ++i < argc) {
+            opts.socket_path = argv[i];
+        } else if ((arg == "--batch" || arg == "-b") && i + 2 < argc) {
+            const auto day = parse_day(argv[++i]);
+            if (!day) return std::nullopt;
+            opts.batch_day = *day;
+            opts.batch_source = argv[++i];
+        } else if ((arg == "--jobs" || arg == "-j") && ++i < argc) {
+            int jobs = 0;
+            if (!aoc::pattern{"{}"}.scan(argv[i], jobs) || jobs < 1) return std::nullopt;
+            opts.jobs = jobs;
+        } else if ((arg == "--cache" || arg == "-c") && ++i < argc) {
+            opts.cache_dir = argv[i];
+        } else if ((arg == "--timeout" || arg == "-t") && ++i < argc) {
+            if (!aoc::pattern{"{}"}.scan(argv[i], opts.timeout_secs) || opts.timeout_secs < 0) return std::nullopt;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    if (!opts.socket_path.empty() && opts.batch_day != 0) {
+        return std::nullopt;
+    }
+
+    return opts;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    const auto opts = parse_args(argc, argv);
+    if (!opts) {
+        fmt::print(stderr, "Usage: {} [--cache DIR] [--timeout SECONDS] [--socket PATH]\n"
+                           "       {} [--cache DIR] [--timeout SECONDS] --batch DAY <input dir or manifest> [--jobs N]\n",
+                   argv[0], argv[0]);
+        return 1;
+    }
+
+    // Keep memory from one job to the next: the solvers' arenas and pmr
+    // containers get their blocks from this pool rather than from malloc,
+    // and freed blocks stay in the pool for the next job to reuse
+    static std::pmr::synchronized_pool_resource pool(
+        std::pmr::pool_options{0, size_t{1} << 24});
+    std::pmr::set_default_resource(&pool);
+
+    if (!opts->cache_dir.empty()) {
+        try {
+            cache.emplace(opts->cache_dir);
+        } catch (const std::exception& e) {
+            fmt::print(stderr, "{}\n", e.what());
+            return 1;
+        }
+    }
+
+    job_timeout = std::chrono::seconds(opts->timeout_secs);
+
+    // Start the worker threads now rather than during the first job
+    aoc::thread_pool::global();
+
+    if (opts->batch_day != 0) {
+        return run_batch(*opts);
+    }
+    if (opts->socket_path.empty()) {
+        serve_stream(stdin, stdout);
+        return 0;
+    }
+    return serve_socket(opts->socket_path);
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+# Checks that a batch with an empty and a garbage input still solves the
+# rest, replying to every input in order. Run as
+#
+#   serve/test_batch.sh ./aoc_serve
+#
+# with a server built as described in README.md.
+
+set -eu
+
+server=${1:?usage: $0 <path to aoc_serve>}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+mkdir "$dir/in"
+
+# Day 1's examples, around an empty file and one that isn't frequency changes
+printf '+1\n-2\n+3\n+1\n' > "$dir/in/1-good"
+printf '' > "$dir/in/2-empty"
+printf 'not a number\n' > "$dir/in/3-garbage"
+printf '+3\n+3\n+4\n-2\n-4\n' > "$dir/in/4-good"
+
+"$server" --batch 1 "$dir/in" --jobs 4 2>/dev/null > "$dir/out"
+cat "$dir/out"
+
+fail() {
+    echo "FAIL: $1" >&2
+    exit 1
+}
+
+[ "$(wc -l < "$dir/out")" -eq 4 ] || fail "expected four replies"
+
+check() { # line, pattern
+    sed -n "$1p" "$dir/out" | grep -q "$2" || fail "reply $1 doesn't match '$2'"
+}
+check 1 "\"path\": \"$dir/in/1-good\", \"part_one\": \"3\".*\"part_two\": \"2\""
+check 2 "\"path\": \"$dir/in/2-empty\", \"error\": "
+check 3 "\"path\": \"$dir/in/3-garbage\", \"error\": "
+check 4 "\"path\": \"$dir/in/4-good\", \"part_one\": \"4\".*\"part_two\": \"10\""
+
+echo "PASS"